@@ -0,0 +1,33 @@
+#include "allocator.h"
+#include <stdlib.h>
+
+static void* libc_alloc(void* ctx, size_t size) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static void* libc_realloc(void* ctx, void* ptr, size_t old_size, size_t size) {
+    (void)ctx, (void)old_size;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx, (void)size;
+    free(ptr);
+}
+
+const struct gdata_allocator gdata_libc_allocator = {
+    .alloc = libc_alloc,
+    .realloc = libc_realloc,
+    .free = libc_free,
+};
+
+static const struct gdata_allocator* default_allocator = &gdata_libc_allocator;
+
+const struct gdata_allocator* gdata_default_allocator(void) {
+    return default_allocator;
+}
+
+void gdata_set_default_allocator(const struct gdata_allocator* allocator) {
+    default_allocator = allocator ? allocator : &gdata_libc_allocator;
+}
@@ -0,0 +1,89 @@
+/**
+ * Memory Allocators
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Containers allocate through a `struct gdata_allocator`, given at creation
+ * to the `*_create_with()` functions. The other constructors take the
+ * global default, libc's malloc/realloc/free unless changed.
+ *
+ * usage:
+ *      struct gdata_allocator pool = {pool_alloc, NULL, pool_free, &my_pool};
+ *      intVector v = vector_create_with(&pool, sizeof(int), 0, NULL);
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Allocation functions and the context given to them.
+ * Sizes are the ones requested: `size` in free() and `old_size` in realloc()
+ * are what was asked when `ptr` was allocated
+ *
+ * @note must outlive every container using it
+ */
+struct gdata_allocator {
+    // NULL if out of memory
+    void* (*alloc)(void* ctx, size_t size);
+    // may be NULL, then alloc, copy and free are used
+    void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t size);
+    void (*free)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+};
+
+// malloc(), realloc() and free()
+extern const struct gdata_allocator gdata_libc_allocator;
+
+/// @brief Allocator used by constructors not given one
+const struct gdata_allocator* gdata_default_allocator(void);
+
+/**
+ * @brief Change the default allocator, NULL restores gdata_libc_allocator.
+ * Containers keep the one they were created with
+ */
+void gdata_set_default_allocator(const struct gdata_allocator* allocator);
+
+// ===== HELPERS ===== //
+
+/*
+ * A NULL allocator is libc's, so containers set up as zeroed
+ * literals (ex: `Stack s = {0};`) still work
+ */
+static inline const struct gdata_allocator* _gdata_allocator(const struct gdata_allocator* a) {
+    return a ? a : &gdata_libc_allocator;
+}
+
+static inline void* gdata_alloc(const struct gdata_allocator* a, size_t size) {
+    a = _gdata_allocator(a);
+    return a->alloc(a->ctx, size);
+}
+
+// `n` zeroed elements of `size` bytes, NULL if their total size overflows
+static inline void* gdata_calloc(const struct gdata_allocator* a, size_t n, size_t size) {
+    if (size && n > SIZE_MAX / size)
+        return NULL;
+    void* ptr = gdata_alloc(a, n * size);
+    if (ptr) memset(ptr, 0, n * size);
+    return ptr;
+}
+
+static inline void gdata_free(const struct gdata_allocator* a, void* ptr, size_t size) {
+    a = _gdata_allocator(a);
+    if (ptr) a->free(a->ctx, ptr, size);
+}
+
+static inline void* gdata_realloc(const struct gdata_allocator* a, void* ptr, size_t old_size, size_t size) {
+    a = _gdata_allocator(a);
+    if (a->realloc)
+        return a->realloc(a->ctx, ptr, old_size, size);
+    void* result = a->alloc(a->ctx, size);
+    if (result == NULL)
+        return NULL;
+    if (ptr) {
+        memcpy(result, ptr, old_size < size ? old_size : size);
+        a->free(a->ctx, ptr, old_size);
+    }
+    return result;
+}
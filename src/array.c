@@ -1,12 +1,25 @@
 #include "array.h"
+#include "sort.h"
+#include <stdint.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Create a new Array with values, if values are passed.
 void* array_create(size_t dsize, size_t initial_size, void* initial_values) {
-    charArray array = malloc(sizeof(*array) + dsize * initial_size);
+    return array_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* array_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                        size_t initial_size, void* initial_values) {
+    charArray array = gdata_alloc(allocator, sizeof(*array) + dsize * initial_size);
     if (array) {
         *(size_t*)&array->size = initial_size;
         *(size_t*)&array->internal.dsize = dsize;
+        array->internal.allocator = allocator;
+        array->internal.mapping = NULL;
         if (initial_values)
             memcpy(array->at, initial_values, dsize * initial_size);
         else
@@ -15,16 +28,28 @@ void* array_create(size_t dsize, size_t initial_size, void* initial_values) {
     return array;
 }
 
+void array_delete(void* array) {
+    charArray A = array;
+    if (A->internal.mapping)
+        array_unmap(A);
+    else
+        gdata_free(A->internal.allocator, A, sizeof(*A) + A->internal.dsize*A->size);
+}
+
 void* array_resize(void* array, const size_t new_size) {
     charArray A = array;
-    array = realloc(array, sizeof(*A) + A->internal.dsize*new_size);
-    *(size_t*)&A->size = new_size;
-    return array;
+    if (A->internal.mapping)
+        return NULL;
+    size_t dsize = A->internal.dsize;
+    A = gdata_realloc(A->internal.allocator, A, sizeof(*A) + dsize*A->size, sizeof(*A) + dsize*new_size);
+    if (A)
+        *(size_t*)&A->size = new_size;
+    return A;
 }
 
 void* array_join(void* a, void* b) {
     charArray A = a, B = b;
-    charArray result = array_create(A->internal.dsize, A->size + B->size, 0);
+    charArray result = array_create_with(A->internal.allocator, A->internal.dsize, A->size + B->size, 0);
 
     size_t bytes_size = A->size*A->internal.dsize;
     memcpy(result->at, A->at, bytes_size);
@@ -38,7 +63,7 @@ void* array_slice(void* array, unsigned int begin, unsigned int end) {
     charArray A = array;
     size_t size = end - begin;
     void* initial_values = A->at + begin*A->internal.dsize;
-    return array_create(A->internal.dsize, size, initial_values);
+    return array_create_with(A->internal.allocator, A->internal.dsize, size, initial_values);
 }
 
 bool array_equals(void* a, void* b) {
@@ -47,4 +72,93 @@ bool array_equals(void* a, void* b) {
         return false;
     size_t dsize = A->internal.dsize;
     return memcmp(A->at, B->at, dsize*A->size) == 0;
-}
\ No newline at end of file
+}
+
+void array_sort(void* array, int(*cmp)(void*, void*)) {
+    charArray A = array;
+    gdata_sort(A->at, A->size, A->internal.dsize, cmp);
+}
+// ===== MAPPED ARRAYS ===== //
+
+/*
+ * Mapped arrays take one page more than their elements, the header is at the
+ * end of it so that `at` is the start of the mapped data:
+ *   [struct array_mapping ... header][elements ...]
+ */
+struct array_mapping {
+    size_t length;
+};
+
+// Alignment of large anonymous arrays, the usual huge page size
+#define ARRAY_HUGE_PAGE ((size_t)2 << 20)
+
+static charArray mapped_header(uint8_t* base, size_t length, size_t dsize, size_t size) {
+    ((struct array_mapping*)base)->length = length;
+    charArray array = (charArray)(base + sysconf(_SC_PAGESIZE) - sizeof(*array));
+    *(size_t*)&array->size = size;
+    *(size_t*)&array->internal.dsize = dsize;
+    // arrays joined or sliced from it
+    array->internal.allocator = gdata_default_allocator();
+    array->internal.mapping = (struct array_mapping*)base;
+    return array;
+}
+
+void* array_map_file(const char* path, size_t dsize) {
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_SHARED;
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        // private copy-on-write pages when the file is read-only
+        fd = open(path, O_RDONLY);
+        flags = MAP_PRIVATE;
+    }
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    uint8_t* base = MAP_FAILED;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t bytes = 0;
+    if (fstat(fd, &st) == 0) {
+        bytes = st.st_size - st.st_size % dsize;
+        base = mmap(NULL, page + bytes, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (base != MAP_FAILED && bytes &&
+        mmap(base + page, bytes, prot, flags | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, page + bytes);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+    return mapped_header(base, page + bytes, dsize, bytes / dsize);
+}
+
+void* array_map_anonymous(size_t dsize, size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t bytes = (size * dsize + page - 1) & ~(page - 1);
+    size_t align = bytes >= ARRAY_HUGE_PAGE ? ARRAY_HUGE_PAGE : page;
+    size_t length = page + bytes + align - page;
+    uint8_t* base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    // keep only [header page][elements] with the elements aligned
+    uint8_t* data = (uint8_t*)(((uintptr_t)base + page + align - 1) & ~(align - 1));
+    uint8_t* end = data + bytes;
+    if (data - page > base)
+        munmap(base, data - page - base);
+    if (base + length > end)
+        munmap(end, base + length - end);
+    base = data - page;
+#ifdef MADV_HUGEPAGE
+    if (align == ARRAY_HUGE_PAGE)
+        madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+    return mapped_header(base, page + bytes, dsize, size);
+}
+
+void array_unmap(void* array) {
+    struct array_mapping* mapping = ((charArray)array)->internal.mapping;
+    munmap(mapping, mapping->length);
+}
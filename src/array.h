@@ -15,22 +15,36 @@
  *
  * Obs:
  *   > every array has fixed size
- *   > You must call `free(array)` later
+ *   > You must call `array_delete(array)` later
  */
 #pragma once
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include "allocator.h"
 
 /**
  * @brief Declares a array of type.
- * The type `typeArray` is will be avaliable to you
+ * The type `typeArray` is will be avaliable to you,
+ * with the specialized `type_array_at()` and `type_array_equals()`
  */
 #define ARRAY_TYPEDEF(type)\
-typedef struct type ## _array {\
+struct type ## _array {\
     const size_t size;\
-    struct { const size_t dsize; } internal;\
+    struct {\
+        const size_t dsize;\
+        const struct gdata_allocator* allocator;\
+        struct array_mapping* mapping;\
+    } internal;\
     type at[];\
-} *type##Array
+};\
+static inline type* type ## _array_at(struct type ## _array* a, size_t index) {\
+    return a->at + index;\
+}\
+static inline bool type ## _array_equals(const struct type ## _array* a, const struct type ## _array* b) {\
+    return a->size == b->size && memcmp(a->at, b->at, a->size * sizeof(type)) == 0;\
+}\
+typedef struct type ## _array *type##Array
 
 // Declaring basic data arrays
 ARRAY_TYPEDEF(char);
@@ -42,7 +56,7 @@ ARRAY_TYPEDEF(float);
 /**
  * @brief Create a new Array with zeros.
  * 
- * Obs: you must call `free(array)` later
+ * Obs: you must call `array_delete(array)` later
  */
 #define ARRAY_ALLOCATE(type, size) (type##Array)array_create(sizeof(type), size, 0)
 
@@ -56,13 +70,27 @@ ARRAY_TYPEDEF(float);
  *      ARRAY_CREATE(int, {0,2,4})
  *      ARRAY_CREATE(float, {2.3f, 0.1f})
  * 
- * Obs: you must call `free(array)` later
+ * Obs: you must call `array_delete(array)` later
  */
 #define ARRAY_CREATE(type, ...) ({\
     type _arr[] = __VA_ARGS__;\
     (type##Array)array_create(sizeof(type), sizeof(_arr)/sizeof(type), _arr);\
 })
 
+/**
+ * @brief Map a file of `type` elements as an Array, see array_map_file()
+ * 
+ * Obs: you must call `array_unmap(array)` later
+ */
+#define ARRAY_MAP_FILE(type, path) (type##Array)array_map_file(path, sizeof(type))
+
+/**
+ * @brief Create a new Array with zeros in huge pages, see array_map_anonymous()
+ * 
+ * Obs: you must call `array_unmap(array)` later
+ */
+#define ARRAY_MAP_ANONYMOUS(type, size) (type##Array)array_map_anonymous(sizeof(type), size)
+
 // ===== FUNCTIONS ===== //
 
 /**
@@ -74,8 +102,22 @@ ARRAY_TYPEDEF(float);
  */
 void* array_create(size_t dsize, size_t size, void *initial_values);
 
+/**
+ * @brief Like array_create(), the array is allocated by `allocator`.
+ * Joined, sliced and resized arrays use it too
+ */
+void* array_create_with(const struct gdata_allocator* allocator, size_t dsize, size_t size, void *initial_values);
+
+/**
+ * @brief Destructor of any array.
+ * `free(array)` is enough for arrays of gdata_libc_allocator
+ */
+void array_delete(void* array);
+
 /** 
  * @brief Reallocates an existing array
+ * @return the array, or NULL if out of memory or the array is mapped.
+ * On failure the original array is kept
  */
 void* array_resize(void* array, const size_t new_size);
 
@@ -92,3 +134,37 @@ void* array_slice(void* array, unsigned int begin, unsigned int end);
  * @brief Check equality between `a` and `b`
  */
 bool array_equals(void* a, void* b);
+
+/**
+ * @brief Sort elements in ascending order
+ * 
+ * @param cmp: comparator, like the ones given to heap_create(). ex: intcmp
+ * @see gdata_sort()
+ */
+void array_sort(void* array, int(*cmp)(void*, void*));
+
+/**
+ * @brief Map a file as an Array, the elements are not loaded or copied:
+ * `at` points to the file pages, shared with every process mapping it.
+ * Changes are written to the file, unless it is read-only for this process
+ * 
+ * @param dsize: size of each element in bytes. trailing bytes of the file
+ * that do not make an element are not in the array
+ * @return NULL if the file can not be mapped
+ * @note free it with array_unmap() or array_delete(). array_resize() returns NULL
+ */
+void* array_map_file(const char* path, size_t dsize);
+
+/**
+ * @brief Create a new Array with zeros, in memory mapped straight from the system.
+ * Large arrays are aligned to and ask for transparent huge pages, reducing
+ * TLB misses on random access
+ * 
+ * @note free it with array_unmap() or array_delete(). array_resize() returns NULL
+ */
+void* array_map_anonymous(size_t dsize, size_t size);
+
+/**
+ * @brief Destructor of arrays from array_map_file() and array_map_anonymous()
+ */
+void array_unmap(void* array);
@@ -0,0 +1,162 @@
+#include "cache.h"
+#include "dict.h"
+#include <time.h>
+
+// Recency list node, the key is stored after it (one allocation per entry)
+struct cache_node {
+    struct cache_node* next; // less recently used
+    struct cache_node* back; // more recently used
+    void* value;
+    void(*del)(void*);
+    size_t size;
+    uint64_t expires; // CLOCK_MONOTONIC milliseconds, 0 never expires
+    char key[];
+};
+
+struct cache {
+    Dict index; // key -> node
+    struct cache_node* head; // most recently used
+    struct cache_node* tail; // least recently used
+    size_t bytes;
+    size_t max_entries;
+    size_t max_bytes;
+    const struct gdata_allocator* allocator;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void cache_unlink(Cache cache, struct cache_node* node) {
+    if (node->back) node->back->next = node->next;
+    else cache->head = node->next;
+    if (node->next) node->next->back = node->back;
+    else cache->tail = node->back;
+}
+
+static void cache_push_front(Cache cache, struct cache_node* node) {
+    node->back = NULL;
+    node->next = cache->head;
+    if (cache->head) cache->head->back = node;
+    else cache->tail = node;
+    cache->head = node;
+}
+
+static void cache_free_node(Cache cache, struct cache_node* node) {
+    if (node->del) node->del(node->value);
+    gdata_free(cache->allocator, node, sizeof(*node) + strlen(node->key) + 1);
+}
+
+// remove a node from the list and the index, freeing its value
+static void cache_erase(Cache cache, struct cache_node* node) {
+    cache_unlink(cache, node);
+    dict_remove(cache->index, node->key);
+    cache->bytes -= node->size;
+    cache_free_node(cache, node);
+}
+
+static bool cache_over_capacity(Cache cache) {
+    return (cache->max_entries && dict_size(cache->index) > cache->max_entries) ||
+           (cache->max_bytes && cache->bytes > cache->max_bytes);
+}
+
+Cache cache_create(size_t max_entries, size_t max_bytes) {
+    return cache_create_with(gdata_default_allocator(), max_entries, max_bytes);
+}
+
+Cache cache_create_with(const struct gdata_allocator* allocator, size_t max_entries, size_t max_bytes) {
+    Cache result = gdata_alloc(allocator, sizeof(*result));
+    if (result) {
+        *result = (struct cache){
+            .index = dict_create_with(allocator, max_entries),
+            .max_entries = max_entries,
+            .max_bytes = max_bytes,
+            .allocator = allocator,
+        };
+        if (result->index == NULL) {
+            gdata_free(allocator, result, sizeof(*result));
+            return NULL;
+        }
+    }
+    return result;
+}
+
+void cache_delete(Cache cache) {
+    cache_clear(cache);
+    dict_delete(cache->index);
+    gdata_free(cache->allocator, cache, sizeof(*cache));
+}
+
+size_t cache_size(Cache cache) {
+    return dict_size(cache->index);
+}
+
+size_t cache_bytes(Cache cache) {
+    return cache->bytes;
+}
+
+void cache_put(Cache cache, const char* key, void* value, size_t size,
+               uint64_t ttl_ms, void(*destructor)(void*)) {
+    uint64_t expires = ttl_ms ? now_ms() + ttl_ms : 0;
+    struct cache_node* node = dict_get(cache->index, key);
+
+    if (node) {
+        if (node->del && node->value != value)
+            node->del(node->value);
+        cache->bytes += size - node->size;
+        cache_unlink(cache, node);
+    } else {
+        size_t len = strlen(key);
+        node = gdata_alloc(cache->allocator, sizeof(*node) + len + 1);
+        if (node == NULL)
+            return;
+        memcpy(node->key, key, len + 1);
+        dict_setref(cache->index, key, node);
+        cache->bytes += size;
+    }
+    *node = (struct cache_node){
+        .value = value,
+        .del = destructor,
+        .size = size,
+        .expires = expires,
+    };
+    cache_push_front(cache, node);
+
+    while (cache_over_capacity(cache) && cache->tail != node)
+        cache_erase(cache, cache->tail);
+}
+
+void* cache_get(Cache cache, const char* key) {
+    struct cache_node* node = dict_get(cache->index, key);
+    if (node == NULL)
+        return NULL;
+    if (node->expires && node->expires <= now_ms()) {
+        cache_erase(cache, node);
+        return NULL;
+    }
+    if (node != cache->head) {
+        cache_unlink(cache, node);
+        cache_push_front(cache, node);
+    }
+    return node->value;
+}
+
+void cache_remove(Cache cache, const char* key) {
+    struct cache_node* node = dict_get(cache->index, key);
+    if (node)
+        cache_erase(cache, node);
+}
+
+void cache_clear(Cache cache) {
+    struct cache_node* node = cache->head;
+    while (node) {
+        struct cache_node* next = node->next;
+        cache_free_node(cache, node);
+        node = next;
+    }
+    dict_clear(cache->index);
+    cache->head = cache->tail = NULL;
+    cache->bytes = 0;
+}
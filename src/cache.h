@@ -0,0 +1,65 @@
+/**
+ * Bounded Cache
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Least recently used cache: a Dict indexes nodes of a recency list,
+ * so get, put and eviction are O(1). The capacity is a number of entries
+ * and/or a total size in bytes, entries may also expire after a time to live.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "allocator.h"
+
+typedef struct cache* Cache;
+
+/**
+ * @brief Allocate a new cache
+ *
+ * @param max_entries: maximum number of entries, 0 for no limit
+ * @param max_bytes: maximum sum of the entry sizes given to cache_put(), 0 for no limit
+ */
+Cache cache_create(size_t max_entries, size_t max_bytes);
+
+/// @brief Like cache_create(), the cache, its entries and index are allocated by `allocator`
+Cache cache_create_with(const struct gdata_allocator* allocator, size_t max_entries, size_t max_bytes);
+
+/**
+ * @brief Free a cache and all it's contents
+ * all detructor functions defined will be called
+ */
+void cache_delete(Cache cache);
+
+/// @brief Get number of entries (expired ones included until they are found)
+size_t cache_size(Cache cache);
+
+/// @brief Get the sum of the entry sizes
+size_t cache_bytes(Cache cache);
+
+/**
+ * @brief Add a new entry or replace a existing one, as most recently used.
+ * Least recently used entries are evicted while the cache is over capacity,
+ * the new entry is never evicted by its own insertion.
+ *
+ * @param size: size accounted for max_bytes
+ * @param ttl_ms: time to live in milliseconds, 0 never expires
+ * @param destructor: function to free the value when it's evicted, expired,
+ * replaced, removed or in cache_delete(). if NULL, nothing is done
+ */
+void cache_put(Cache cache, const char* key, void* value, size_t size,
+               uint64_t ttl_ms, void(*destructor)(void*));
+
+/**
+ * @brief Get the value of key and mark it as most recently used.
+ * @return value or NULL if not defined or expired
+ */
+void* cache_get(Cache cache, const char* key);
+
+/// @brief Remove a key from the cache
+void cache_remove(Cache cache, const char* key);
+
+/// @brief Remove all entries
+void cache_clear(Cache cache);
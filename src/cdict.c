@@ -0,0 +1,496 @@
+#include "cdict.h"
+#include "dict.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CDICT_DEFAULT_SHARDS 64
+#define CDICT_GROUP_WIDTH 16
+#define CDICT_INLINE_KEY_SIZE 16
+
+// Retired objects kept before trying to free them
+#define CDICT_RECLAIM_THRESHOLD 64
+
+#define CTRL_EMPTY   ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+// Maximum load: 7/8 of the slots (full + deleted)
+#define CDICT_MAX_LOAD(capacity) ((capacity) - (capacity)/8)
+
+/*
+ * Same layout as the Dict tables, but readers run while a writer modifies
+ * the table, so:
+ *  - a pair is written before its control byte is published (release)
+ *    and never changes after it, except for the value (atomic);
+ *  - slots are never reused: removed slots stay DELETED until the table
+ *    is copied into a new one, which is then published atomically.
+ */
+struct cdict_pair {
+    union {
+        char inline_key[CDICT_INLINE_KEY_SIZE];
+        char* ptr;
+    } key;
+    size_t len;
+    uint64_t hash;
+    void* value;
+    void(*del)(void*);
+};
+
+struct cdict_table {
+    size_t capacity;
+    size_t used; // full and deleted slots
+    int8_t* ctrl;
+    struct cdict_pair pairs[];
+};
+
+struct cdict_shard {
+    pthread_mutex_t lock;
+    struct cdict_table* table;
+    size_t size;
+} __attribute__((aligned(64)));
+
+// Memory waiting for the readers that may still see it
+struct cdict_retired {
+    void* ptr;
+    void(*free)(void*); // NULL for memory of the dict, `size` bytes from its allocator
+    size_t size;
+    uint64_t epoch;
+};
+
+struct cdict {
+    struct cdict_shard* shards;
+    void* shards_memory;    // allocation holding `shards`, aligned by hand
+    size_t shards_bytes;
+    size_t num_shards;
+    unsigned shard_shift;
+    uint64_t seed;
+    pthread_mutex_t retire_lock;
+    struct cdict_retired* retired;
+    size_t num_retired;
+    size_t alloc_retired;
+    size_t reserved_retired; // slots promised by cdict_reserve()
+    const struct gdata_allocator* allocator;
+};
+
+// ===== EPOCHS ===== //
+
+/*
+ * Epoch based reclamation:
+ * readers announce the global epoch while they read. The global epoch only
+ * advances when every reader announced the current one, so memory retired
+ * at epoch `e` is unreachable to all readers once the global epoch is e+2.
+ */
+struct epoch_record {
+    uint64_t epoch; // announced epoch, 0 outside of read sections
+    bool in_use;
+    struct epoch_record* next;
+};
+
+static uint64_t global_epoch = 1;
+static struct epoch_record* epoch_records = NULL;
+static pthread_key_t epoch_key;
+static pthread_once_t epoch_once = PTHREAD_ONCE_INIT;
+static __thread struct epoch_record* local_record = NULL;
+static __thread unsigned local_nesting = 0;
+
+// records of finished threads are reused by new ones
+static void epoch_release_record(void* record) {
+    struct epoch_record* r = record;
+    __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&r->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void epoch_init(void) {
+    pthread_key_create(&epoch_key, epoch_release_record);
+}
+
+static struct epoch_record* epoch_get_record(void) {
+    if (local_record)
+        return local_record;
+    pthread_once(&epoch_once, epoch_init);
+
+    struct epoch_record* record = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE);
+    for (; record; record = record->next) {
+        bool expected = false;
+        if (__atomic_compare_exchange_n(&record->in_use, &expected, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (record == NULL) {
+        record = calloc(1, sizeof(*record));
+        if (record == NULL)
+            abort();
+        record->in_use = true;
+        record->next = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE);
+        while (!__atomic_compare_exchange_n(&epoch_records, &record->next, record, true,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    }
+    pthread_setspecific(epoch_key, record);
+    local_record = record;
+    return record;
+}
+
+void cdict_read_begin(void) {
+    if (local_nesting++ == 0) {
+        struct epoch_record* record = epoch_get_record();
+        uint64_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&record->epoch, epoch, __ATOMIC_SEQ_CST);
+        // the announcement must be visible before any pointer is read
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void cdict_read_end(void) {
+    if (--local_nesting == 0)
+        __atomic_store_n(&local_record->epoch, 0, __ATOMIC_RELEASE);
+}
+
+// Advance the global epoch if every reader is in the current one
+static uint64_t epoch_try_advance(void) {
+    uint64_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    struct epoch_record* record = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE);
+    for (; record; record = record->next) {
+        uint64_t announced = __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST);
+        if (announced && announced != epoch)
+            return epoch;
+    }
+    __atomic_compare_exchange_n(&global_epoch, &epoch, epoch + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+}
+
+static void retired_free(CDict dict, const struct cdict_retired* r) {
+    if (r->free)
+        r->free(r->ptr);
+    else
+        gdata_free(dict->allocator, r->ptr, r->size);
+}
+
+/*
+ * Move up to CDICT_RECLAIM_THRESHOLD records no reader can see anymore
+ * to `expired`, retire_lock must be held
+ */
+static size_t cdict_take_expired(CDict dict, struct cdict_retired* expired) {
+    uint64_t epoch = epoch_try_advance();
+    size_t kept = 0, count = 0;
+    for (size_t i = 0; i < dict->num_retired; i++) {
+        struct cdict_retired* r = dict->retired + i;
+        if (r->epoch + 2 <= epoch && count < CDICT_RECLAIM_THRESHOLD)
+            expired[count++] = *r;
+        else
+            dict->retired[kept++] = *r;
+    }
+    dict->num_retired = kept;
+    return count;
+}
+
+/*
+ * Make room in the retired list for `count` objects, before they are
+ * unpublished: retiring them can then not fail
+ */
+static bool cdict_reserve(CDict dict, size_t count) {
+    pthread_mutex_lock(&dict->retire_lock);
+    size_t needed = dict->num_retired + dict->reserved_retired + count;
+    if (needed > dict->alloc_retired) {
+        size_t alloc = dict->alloc_retired ? 2*dict->alloc_retired : CDICT_RECLAIM_THRESHOLD;
+        if (alloc < needed) alloc = needed;
+        struct cdict_retired* retired = gdata_realloc(dict->allocator, dict->retired,
+                                                      dict->alloc_retired * sizeof(*retired),
+                                                      alloc * sizeof(*retired));
+        if (retired == NULL) {
+            pthread_mutex_unlock(&dict->retire_lock);
+            return false;
+        }
+        dict->retired = retired;
+        dict->alloc_retired = alloc;
+    }
+    dict->reserved_retired += count;
+    pthread_mutex_unlock(&dict->retire_lock);
+    return true;
+}
+
+static void cdict_unreserve(CDict dict, size_t count) {
+    pthread_mutex_lock(&dict->retire_lock);
+    dict->reserved_retired -= count;
+    pthread_mutex_unlock(&dict->retire_lock);
+}
+
+/*
+ * Free `ptr` once no reader can see it, with `free_function` or,
+ * if NULL, as `size` bytes of the dict's allocator.
+ * A slot must have been reserved, and no lock of the dict may be held:
+ * destructors run here and may use the dict
+ */
+static void cdict_retire(CDict dict, void* ptr, void(*free_function)(void*), size_t size) {
+    struct cdict_retired expired[CDICT_RECLAIM_THRESHOLD];
+    size_t count = 0;
+    pthread_mutex_lock(&dict->retire_lock);
+    dict->reserved_retired--;
+    dict->retired[dict->num_retired++] = (struct cdict_retired){
+        .ptr = ptr,
+        .free = free_function,
+        .size = size,
+        .epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST),
+    };
+    if (dict->num_retired >= CDICT_RECLAIM_THRESHOLD)
+        count = cdict_take_expired(dict, expired);
+    pthread_mutex_unlock(&dict->retire_lock);
+    for (size_t i = 0; i < count; i++)
+        retired_free(dict, expired + i);
+}
+
+// ===== TABLE ===== //
+
+static inline const char* pair_key(const struct cdict_pair* pair) {
+    return pair->len < CDICT_INLINE_KEY_SIZE ? pair->key.inline_key : pair->key.ptr;
+}
+
+static inline size_t table_bytes(size_t capacity) {
+    return sizeof(struct cdict_table) + capacity * (sizeof(struct cdict_pair) + 1);
+}
+
+static struct cdict_table* table_create(CDict dict, size_t capacity) {
+    struct cdict_table* table = gdata_alloc(dict->allocator, table_bytes(capacity));
+    if (table) {
+        table->capacity = capacity;
+        table->used = 0;
+        table->ctrl = (int8_t*)(table->pairs + capacity);
+        memset(table->ctrl, CTRL_EMPTY, capacity);
+    }
+    return table;
+}
+
+static size_t capacity_for(size_t num_elements) {
+    size_t capacity = CDICT_GROUP_WIDTH;
+    while (CDICT_MAX_LOAD(capacity) < num_elements)
+        capacity *= 2;
+    return capacity;
+}
+
+#define PROBE_FOR(group, table, h) \
+    for (size_t _groups = (table)->capacity / CDICT_GROUP_WIDTH, _step = 0, \
+         group = ((h) >> 7) & (_groups - 1); \
+         _step < _groups; \
+         group = (group + ++_step) & (_groups - 1))
+
+// Lookup safe to run while a writer modifies the table
+static struct cdict_pair* table_find(struct cdict_table* table, const char* key,
+                                     size_t len, uint64_t h) {
+    int8_t h2 = h & 0x7F;
+    PROBE_FOR(group, table, h) {
+        bool has_empty = false;
+        for (size_t slot = group * CDICT_GROUP_WIDTH, end = slot + CDICT_GROUP_WIDTH; slot < end; slot++) {
+            int8_t ctrl = __atomic_load_n(table->ctrl + slot, __ATOMIC_ACQUIRE);
+            if (ctrl == h2) {
+                struct cdict_pair* pair = table->pairs + slot;
+                if (pair->hash == h && pair->len == len && memcmp(pair_key(pair), key, len) == 0)
+                    return pair;
+            }
+            has_empty |= ctrl == CTRL_EMPTY;
+        }
+        if (has_empty)
+            break;
+    }
+    return NULL;
+}
+
+// Publish a pair in the first EMPTY slot (slots are never reused)
+static void table_insert(struct cdict_table* table, const struct cdict_pair* pair) {
+    PROBE_FOR(group, table, pair->hash) {
+        for (size_t slot = group * CDICT_GROUP_WIDTH, end = slot + CDICT_GROUP_WIDTH; slot < end; slot++) {
+            if (table->ctrl[slot] == CTRL_EMPTY) {
+                table->pairs[slot] = *pair;
+                table->used++;
+                __atomic_store_n(table->ctrl + slot, (int8_t)(pair->hash & 0x7F), __ATOMIC_RELEASE);
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * Copy the shard into a bigger (or cleaner) table, shard lock must be held
+ * @return the old table, to retire once the lock is released. NULL if out of memory
+ */
+static struct cdict_table* shard_resize(CDict dict, struct cdict_shard* shard) {
+    struct cdict_table* old = shard->table;
+    struct cdict_table* table = table_create(dict, capacity_for(2*(shard->size + 1)));
+    if (table == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < old->capacity; i++) {
+        if (old->ctrl[i] >= 0)
+            table_insert(table, old->pairs + i);
+    }
+    __atomic_store_n(&shard->table, table, __ATOMIC_RELEASE);
+    return old;
+}
+
+static inline struct cdict_shard* cdict_shard(CDict dict, uint64_t h) {
+    return dict->shards + (dict->shard_shift < 64 ? h >> dict->shard_shift : 0);
+}
+
+// ===== CDICT ===== //
+
+CDict cdict_create(size_t num_shards, size_t table_size) {
+    return cdict_create_with(gdata_default_allocator(), num_shards, table_size);
+}
+
+CDict cdict_create_with(const struct gdata_allocator* allocator, size_t num_shards, size_t table_size) {
+    if (num_shards == 0)
+        num_shards = CDICT_DEFAULT_SHARDS;
+    unsigned bits = 0;
+    while (((size_t)1 << bits) < num_shards)
+        bits++;
+    num_shards = (size_t)1 << bits;
+
+    CDict dict = gdata_calloc(allocator, 1, sizeof(*dict));
+    if (dict == NULL)
+        return NULL;
+    // shards are on their own cache lines
+    dict->allocator = allocator;
+    dict->shards_bytes = num_shards * sizeof(struct cdict_shard) + 63;
+    dict->shards_memory = gdata_alloc(allocator, dict->shards_bytes);
+    if (dict->shards_memory == NULL) {
+        gdata_free(allocator, dict, sizeof(*dict));
+        return NULL;
+    }
+    dict->shards = (struct cdict_shard*)(((uintptr_t)dict->shards_memory + 63) & ~(uintptr_t)63);
+    dict->num_shards = num_shards;
+    dict->shard_shift = 64 - bits;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    dict->seed = dict_hash(&now, sizeof(now), (uintptr_t)dict);
+    pthread_mutex_init(&dict->retire_lock, NULL);
+
+    size_t capacity = capacity_for(table_size / num_shards + 1);
+    for (size_t i = 0; i < num_shards; i++) {
+        struct cdict_shard* shard = dict->shards + i;
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->size = 0;
+        shard->table = table_create(dict, capacity);
+        if (shard->table == NULL) {
+            dict->num_shards = i;
+            cdict_delete(dict);
+            return NULL;
+        }
+    }
+    return dict;
+}
+
+void cdict_delete(CDict dict) {
+    for (size_t i = 0; i < dict->num_shards; i++) {
+        struct cdict_shard* shard = dict->shards + i;
+        struct cdict_table* table = shard->table;
+        for (size_t slot = 0; slot < table->capacity; slot++) {
+            if (table->ctrl[slot] < 0) continue;
+            struct cdict_pair* pair = table->pairs + slot;
+            if (pair->del) pair->del(pair->value);
+            if (pair->len >= CDICT_INLINE_KEY_SIZE)
+                gdata_free(dict->allocator, pair->key.ptr, pair->len + 1);
+        }
+        gdata_free(dict->allocator, table, table_bytes(table->capacity));
+        pthread_mutex_destroy(&shard->lock);
+    }
+    for (size_t i = 0; i < dict->num_retired; i++)
+        retired_free(dict, dict->retired + i);
+    gdata_free(dict->allocator, dict->retired, dict->alloc_retired * sizeof(*dict->retired));
+    pthread_mutex_destroy(&dict->retire_lock);
+    gdata_free(dict->allocator, dict->shards_memory, dict->shards_bytes);
+    gdata_free(dict->allocator, dict, sizeof(*dict));
+}
+
+size_t cdict_size(CDict dict) {
+    size_t size = 0;
+    for (size_t i = 0; i < dict->num_shards; i++)
+        size += __atomic_load_n(&dict->shards[i].size, __ATOMIC_RELAXED);
+    return size;
+}
+
+void cdict_set(CDict dict, const char* key, void* value, void(*destructor)(void*)) {
+    size_t len = strlen(key);
+    uint64_t h = dict_hash(key, len, dict->seed);
+    struct cdict_shard* shard = cdict_shard(dict, h);
+
+    pthread_mutex_lock(&shard->lock);
+    struct cdict_pair* pair = table_find(shard->table, key, len, h);
+    if (pair) {
+        void* old_value = pair->value;
+        void(*old_del)(void*) = pair->del;
+        if (old_del && old_value != value && !cdict_reserve(dict, 1)) {
+            pthread_mutex_unlock(&shard->lock);
+            return;
+        }
+        pair->del = destructor;
+        __atomic_store_n(&pair->value, value, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&shard->lock);
+        if (old_del && old_value != value)
+            cdict_retire(dict, old_value, old_del, 0);
+        return;
+    }
+
+    struct cdict_table* old_table = NULL;
+    if (shard->table->used >= CDICT_MAX_LOAD(shard->table->capacity)) {
+        if (!cdict_reserve(dict, 1)) {
+            pthread_mutex_unlock(&shard->lock);
+            return;
+        }
+        old_table = shard_resize(dict, shard);
+        if (old_table == NULL) {
+            cdict_unreserve(dict, 1);
+            pthread_mutex_unlock(&shard->lock);
+            return;
+        }
+    }
+
+    struct cdict_pair new_pair = {.len = len, .hash = h, .value = value, .del = destructor};
+    char* dest = new_pair.key.inline_key;
+    if (len < CDICT_INLINE_KEY_SIZE || (dest = new_pair.key.ptr = gdata_alloc(dict->allocator, len + 1))) {
+        memcpy(dest, key, len + 1);
+        table_insert(shard->table, &new_pair);
+        __atomic_store_n(&shard->size, shard->size + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    if (old_table)
+        cdict_retire(dict, old_table, NULL, table_bytes(old_table->capacity));
+}
+
+void* cdict_get(CDict dict, const char* key) {
+    size_t len = strlen(key);
+    uint64_t h = dict_hash(key, len, dict->seed);
+    struct cdict_shard* shard = cdict_shard(dict, h);
+
+    cdict_read_begin();
+    struct cdict_table* table = __atomic_load_n(&shard->table, __ATOMIC_ACQUIRE);
+    struct cdict_pair* pair = table_find(table, key, len, h);
+    void* value = pair ? __atomic_load_n(&pair->value, __ATOMIC_ACQUIRE) : NULL;
+    cdict_read_end();
+    return value;
+}
+
+void cdict_remove(CDict dict, const char* key) {
+    size_t len = strlen(key);
+    uint64_t h = dict_hash(key, len, dict->seed);
+    struct cdict_shard* shard = cdict_shard(dict, h);
+
+    pthread_mutex_lock(&shard->lock);
+    struct cdict_pair* pair = table_find(shard->table, key, len, h);
+    size_t retired = pair ? (pair->del != NULL) + (pair->len >= CDICT_INLINE_KEY_SIZE) : 0;
+    if (pair == NULL || (retired && !cdict_reserve(dict, retired))) {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+    size_t slot = pair - shard->table->pairs;
+    __atomic_store_n(shard->table->ctrl + slot, CTRL_DELETED, __ATOMIC_RELEASE);
+    __atomic_store_n(&shard->size, shard->size - 1, __ATOMIC_RELAXED);
+    struct cdict_pair removed = *pair;
+    pthread_mutex_unlock(&shard->lock);
+
+    if (removed.del)
+        cdict_retire(dict, removed.value, removed.del, 0);
+    if (removed.len >= CDICT_INLINE_KEY_SIZE)
+        cdict_retire(dict, removed.key.ptr, NULL, removed.len + 1);
+}
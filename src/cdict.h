@@ -0,0 +1,81 @@
+/**
+ * Concurrent Dictionary
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Hash map safe to use from many threads at once.
+ * Keys are spread over independently locked shards, so writers to
+ * different shards do not wait for each other, and readers never lock:
+ * memory released by writers is only freed once no reader can
+ * still see it (epoch based reclamation).
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "allocator.h"
+
+typedef struct cdict* CDict;
+
+/**
+ * @brief Allocate a new concurrent dictionary
+ *
+ * @param num_shards: number of independently locked parts (rounded up to a power of two).
+ * 0 uses a default suited for a few dozen threads
+ * @param table_size: number of elements expected
+ */
+CDict cdict_create(size_t num_shards, size_t table_size);
+
+/**
+ * @brief Like cdict_create(), the dictionary, its tables and keys are allocated
+ * by `allocator`. Values given to cdict_set() keep their own destructors
+ * @note writers allocate from many threads and memory is freed by whichever
+ * thread reclaims it, so the allocator must be thread safe
+ */
+CDict cdict_create_with(const struct gdata_allocator* allocator, size_t num_shards, size_t table_size);
+
+/**
+ * @brief Free a dictionary and all it's contents
+ * all detructor functions defined will be called
+ *
+ * @note no other thread may be using the dictionary
+ */
+void cdict_delete(CDict dict);
+
+/// @brief Get number of elements defined
+size_t cdict_size(CDict dict);
+
+/**
+ * @brief Add a new key-value or update a existing one.
+ *
+ * @param destructor: function to free the value when it's removed, replaced
+ * or in cdict_delete(). It's called once no reader can still see the value,
+ * by a thread not holding any lock of the dict: it may use the dict
+ * @note does nothing if out of memory
+ */
+void cdict_set(CDict dict, const char* key, void* value, void(*destructor)(void*));
+
+/**
+ * @brief Get the value of key, without locking.
+ *
+ * @return value or NULL if not defined.
+ * @note if another thread can remove or replace the key, use the value
+ * between cdict_read_begin() and cdict_read_end()
+ */
+void* cdict_get(CDict dict, const char* key);
+
+/**
+ * @brief Remove a key from the dictionary.
+ * @note does nothing if out of memory, like cdict_set()
+ */
+void cdict_remove(CDict dict, const char* key);
+
+/**
+ * @brief Keep values returned by cdict_get() alive until cdict_read_end().
+ * Calls can be nested.
+ */
+void cdict_read_begin(void);
+
+/// @brief End a section started by cdict_read_begin()
+void cdict_read_end(void);
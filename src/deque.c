@@ -0,0 +1,132 @@
+#include "deque.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+DEQUE_TYPEDEF(uint8_t);
+
+// Smallest capacity allocated, capacities are powers of two
+#define DEQUE_MIN_ALLOC 8
+
+static inline size_t slot_of(const struct uint8_t_deque* d, size_t index) {
+    return (d->internal.head + index) & (d->internal.alloc - 1);
+}
+
+/*
+ * Copy `n` elements between `data` and the deque starting at `index`,
+ * in at most two parts when the range wraps around the buffer end
+ */
+static void copy_range(struct uint8_t_deque* d, size_t index, void* data, size_t n, bool in) {
+    size_t dsize = d->internal.dsize;
+    size_t slot = slot_of(d, index);
+    size_t first = d->internal.alloc - slot < n ? d->internal.alloc - slot : n;
+    uint8_t* buffer = d->internal.buffer;
+
+    if (in) {
+        memcpy(buffer + slot*dsize, data, first*dsize);
+        memcpy(buffer, (uint8_t*)data + first*dsize, (n - first)*dsize);
+    } else {
+        memcpy(data, buffer + slot*dsize, first*dsize);
+        memcpy((uint8_t*)data + first*dsize, buffer, (n - first)*dsize);
+    }
+}
+
+// Make room for `num_elements` more, the elements are unwrapped in the new buffer
+static bool grow(uint8_tDeque d, size_t num_elements) {
+    size_t needed = d->size + num_elements;
+    if (needed <= d->internal.alloc)
+        return true;
+
+    size_t alloc = d->internal.alloc ? 2*d->internal.alloc : DEQUE_MIN_ALLOC;
+    while (alloc < needed)
+        alloc *= 2;
+    const struct gdata_allocator* allocator = d->internal.allocator;
+    uint8_t* buffer = gdata_alloc(allocator, alloc * d->internal.dsize);
+    if (buffer == NULL)
+        return false;
+    if (d->size)
+        copy_range(d, 0, buffer, d->size, false);
+    gdata_free(allocator, d->internal.buffer, d->internal.alloc * d->internal.dsize);
+    d->internal.buffer = buffer;
+    d->internal.alloc = alloc;
+    d->internal.head = 0;
+    return true;
+}
+
+void* deque_create(size_t dsize, size_t initial_size, void* initial_values) {
+    return deque_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* deque_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                        size_t initial_size, void* initial_values) {
+    uint8_tDeque deque = gdata_alloc(allocator, sizeof(*deque));
+    if (deque) {
+        *deque = (struct uint8_t_deque){.internal.dsize = dsize, .internal.allocator = allocator};
+        if (!grow(deque, initial_size)) {
+            gdata_free(allocator, deque, sizeof(*deque));
+            return NULL;
+        }
+        if (initial_size == 0)
+            return deque;
+        if (initial_values)
+            memcpy(deque->internal.buffer, initial_values, initial_size*dsize);
+        else
+            memset(deque->internal.buffer, 0, initial_size*dsize);
+        deque->size = initial_size;
+    }
+    return deque;
+}
+
+void deque_delete(void* deque) {
+    uint8_tDeque d = deque;
+    gdata_free(d->internal.allocator, d->internal.buffer, d->internal.alloc * d->internal.dsize);
+    gdata_free(d->internal.allocator, d, sizeof(*d));
+}
+
+void deque_pushback(void* deque, size_t num_elements, void* data) {
+    uint8_tDeque d = deque;
+    if (!grow(d, num_elements))
+        return;
+    if (data) copy_range(d, d->size, data, num_elements, true);
+    d->size += num_elements;
+}
+
+void deque_pushfront(void* deque, size_t num_elements, void* data) {
+    uint8_tDeque d = deque;
+    if (!grow(d, num_elements))
+        return;
+    d->internal.head = (d->internal.head - num_elements) & (d->internal.alloc - 1);
+    d->size += num_elements;
+    if (data) copy_range(d, 0, data, num_elements, true);
+}
+
+void* deque_popback(void* deque) {
+    uint8_tDeque d = deque;
+    d->size--;
+    return deque_at(d, d->size);
+}
+
+void* deque_popfront(void* deque) {
+    uint8_tDeque d = deque;
+    void* front = deque_at(d, 0);
+    d->internal.head = slot_of(d, 1);
+    d->size--;
+    return front;
+}
+
+void* deque_at(const void* deque, size_t index) {
+    const struct uint8_t_deque* d = deque;
+    return d->internal.buffer + slot_of(d, index)*d->internal.dsize;
+}
+
+void deque_reserve(void* deque, size_t capacity) {
+    uint8_tDeque d = deque;
+    if (capacity > d->size)
+        grow(d, capacity - d->size);
+}
+
+void deque_clear(void* deque) {
+    uint8_tDeque d = deque;
+    d->size = 0;
+    d->internal.head = 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * Generic Deque
+ * 
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ * 
+ * Circular buffer: pushing and popping at both ends is O(1) and
+ * elements only move when the buffer grows.
+ * 
+ * usage:
+ *      call `DEQUE_TYPEDEF(type)` and 
+ *      use `typeDeque` as your deque
+ */
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+ * @brief Declare a type of deque and use `typeDeque`
+ * @usage:
+ *      DEQUE_TYPEDEF(MyType);
+ *      and MyTypeDeque is now available
+ * 
+ * @note: like VECTOR_TYPEDEF, type must be a single name
+ */
+#define DEQUE_TYPEDEF(type)\
+typedef struct type ## _deque {\
+    size_t size;\
+    struct {\
+        type *buffer;\
+        size_t head;\
+        size_t alloc;\
+        size_t dsize;\
+        const struct gdata_allocator *allocator;\
+    } internal;\
+} *type ## Deque
+
+// Declaring basic data deques
+DEQUE_TYPEDEF(char);
+DEQUE_TYPEDEF(int);
+DEQUE_TYPEDEF(float);
+
+// ===== MACROS ===== //
+
+/**
+ * @brief Creates a new deque with values if passed
+ * @note: You must call `deque_delete()` later
+ * 
+ * @param type: any defined type. ex: int, float, etc...
+ * @param __VA_ARGS__: values to initialize deque
+ */
+#define DEQUE_CREATE(type, ...) ({\
+    typeof(type) _deq[] = {__VA_ARGS__};\
+    deque_create(sizeof(type), sizeof(_deq)/sizeof(*_deq), _deq);\
+})
+
+/**
+ * @brief Push one or more values to deque's end
+ * @param deque: any type of deque
+ * @param __VA_ARGS__: values to push, the type inside deque or literal
+ */
+#define DEQUE_PUSHBACK(deque, ...) ({\
+    typeof(*(deque)->internal.buffer) _deq[] = {__VA_ARGS__};\
+    deque_pushback(deque, sizeof(_deq)/sizeof(*_deq), _deq);\
+})
+
+/**
+ * @brief Push one or more values to deque's begin, in the order given
+ * @param deque: any type of deque
+ * @param __VA_ARGS__: values to push, the type inside deque or literal
+ */
+#define DEQUE_PUSHFRONT(deque, ...) ({\
+    typeof(*(deque)->internal.buffer) _deq[] = {__VA_ARGS__};\
+    deque_pushfront(deque, sizeof(_deq)/sizeof(*_deq), _deq);\
+})
+
+/**
+ * @brief Get the last element and remove it from deque
+ * @return value
+ */
+#define DEQUE_POPBACK(deque) (*(typeof((deque)->internal.buffer))deque_popback(deque))
+
+/**
+ * @brief Get the first element and remove it from deque
+ * @return value
+ */
+#define DEQUE_POPFRONT(deque) (*(typeof((deque)->internal.buffer))deque_popfront(deque))
+
+/**
+ * @brief Element at index, can be assigned
+ * @ex: DEQUE_AT(deque, 0) = 10;
+ */
+#define DEQUE_AT(deque, index) (*(typeof((deque)->internal.buffer))deque_at(deque, index))
+
+// ===== FUNCTIONS ===== //
+
+/**
+ * @brief Create deque and pass values
+ * 
+ * @param dsize: size of each element in bytes
+ * @param initial_size: initial size of the deque. (0 is valid)
+ * @param initial_values: pointer to data that will be pushed first.
+ * if NULL, the elements are set to zero
+ */
+void* deque_create(size_t dsize, size_t initial_size, void* initial_values);
+
+/// @brief Like deque_create(), the deque and its buffer are allocated by `allocator`
+void* deque_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                        size_t initial_size, void* initial_values);
+
+// Destructor
+void deque_delete(void* deque);
+
+/**
+ * @brief Push data to deque's end.
+ * 
+ * @param num_elements: number of elements in data
+ * @param data: array with values to be pushed (values will be copied)
+ * 
+ * @see DEQUE_PUSHBACK() macro
+ */
+void deque_pushback(void* deque, size_t num_elements, void* data);
+
+/**
+ * @brief Push data to deque's begin, data[0] becomes the first element
+ * 
+ * @param num_elements: number of elements in data
+ * @param data: array with values to be pushed (values will be copied)
+ * 
+ * @see DEQUE_PUSHFRONT() macro
+ */
+void deque_pushfront(void* deque, size_t num_elements, void* data);
+
+/**
+ * @brief Pop deque's last element
+ * @returns: reference to value, valid until the next push
+ * @see DEQUE_POPBACK()
+ */
+void* deque_popback(void* deque);
+
+/**
+ * @brief Pop deque's first element
+ * @returns: reference to value, valid until the next push
+ * @see DEQUE_POPFRONT()
+ */
+void* deque_popfront(void* deque);
+
+// Get a pointer to the given index of a deque.
+void* deque_at(const void* deque, size_t index);
+
+/**
+ * @brief Make room for `capacity` elements,
+ * pushing up to that size does not reallocate
+ */
+void deque_reserve(void* deque, size_t capacity);
+
+// Remove all elements
+void deque_clear(void* deque);
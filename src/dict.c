@@ -1,76 +1,1137 @@
 #include "dict.h"
+#include "utils/threads.h"
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define DICT_MAX_KEY_SIZE 64
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Keys shorter than this are stored inside the pair, longer ones in the key arena
+#define DICT_INLINE_KEY_SIZE 16
+
+// Key arena chunk sizes, each chunk doubles the previous one up to the max
+#define DICT_ARENA_MIN_CHUNK 4096
+#define DICT_ARENA_MAX_CHUNK (1 << 20)
+
+/*
+ * Open addressing table (swiss table like).
+ *
+ * Every slot has one control byte. Full slots hold the low 7 bits of
+ * the key hash, free slots are negative (EMPTY or DELETED). Slots are
+ * probed one group at a time, a group is matched in a single SIMD compare
+ */
+#if defined(__AVX2__)
+#define DICT_GROUP_WIDTH 32
+#else
+#define DICT_GROUP_WIDTH 16
+#endif
+
+#define CTRL_EMPTY   ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+// Default load factors, see dict_set_load_factor()
+#define DICT_DEFAULT_GROW   0.875f
+#define DICT_DEFAULT_SHRINK 0.0f
+
+// Number of groups moved to the new table on each operation while rehashing
+#define DICT_REHASH_STEP 1
+
+// Keys hashed and prefetched together by dict_get_many() and dict_set_many()
+#define DICT_BATCH_SIZE 16
+
+// Filter blocks are one cache line of 4 bits counters, see dict_enable_filter()
+#define DICT_FILTER_BLOCK_SIZE 64
+#define DICT_FILTER_KEYS_PER_BLOCK 8
+#define DICT_FILTER_HASHES 4
 
 struct dict_pair {
-    struct dict_pair* next;
-    void(*del)(void*);
-    char key[DICT_MAX_KEY_SIZE];
+    union {
+        char inline_key[DICT_INLINE_KEY_SIZE];
+        const char* ptr;
+    } key;
+    size_t len;
+    uint64_t hash;
     void* value;
+    void(*del)(void*);
+};
+
+// Bump allocated storage for long keys
+struct dict_arena_chunk {
+    struct dict_arena_chunk* next;
+    size_t used;
+    size_t size;
+    char data[];
 };
 
+/*
+ * Elements of ordered dicts, in insertion order (see dict_create_ordered()).
+ * Removed entries are left as holes until the array is compacted
+ */
+struct dict_entries {
+    struct dict_pair* at;
+    size_t size; // holes included
+    size_t alloc;
+    size_t deleted;
+    uint64_t version; // changes when entries move, see dict_iter_next()
+    struct dict_arena_chunk* arena;
+};
+
+// len of removed entries
+#define DICT_ENTRY_REMOVED SIZE_MAX
+
+/*
+ * Each table owns the long keys of its pairs. Rehashing copies them to the
+ * arena of the new table, so space of removed keys is reclaimed on resize.
+ *
+ * Tables of ordered dicts hold indexes to the shared entries instead of
+ * pairs, rehashing them only moves the indexes
+ */
+struct dict_table {
+    struct dict_pair* pairs;
+    uint32_t* index;
+    struct dict_entries* entries;
+    int8_t* ctrl;
+    size_t capacity;
+    size_t size;
+    size_t deleted;
+    struct dict_arena_chunk* arena;
+};
+
+/*
+ * While resizing, elements are moved from ht[0] to ht[1] a few groups at
+ * a time on each operation (incremental rehash). New elements always go
+ * to ht[1], and lookups look at both tables.
+ */
 struct dict {
-    struct dict_pair** table;
-    size_t table_size;
-    size_t num_elements;
+    struct dict_table ht[2];
+    uint64_t seed;
+    size_t rehash_index; // next group of ht[0] to move, NOT_REHASHING if none
+    uint64_t version;    // changes when tables are replaced, see dict_iter_next()
+    float grow;
+    float shrink;
     const char** keys;
+    size_t keys_alloc;
     bool update_keys;
+    const struct dict_image* image; // read-only mapped snapshot, see dict_open_mmap()
+    size_t image_size;
+    struct dict_entries* entries; // NULL if not ordered
+    struct dict_filter* filter;   // NULL if not enabled
+    const struct gdata_allocator* allocator;
+};
+
+#define NOT_REHASHING SIZE_MAX
+
+// ===== HASHING ===== //
+
+// wyhash (final version 4) constants
+static const uint64_t P0 = 0xa0761d6478bd642full;
+static const uint64_t P1 = 0xe7037ed1a0b428dbull;
+static const uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+static const uint64_t P3 = 0x589965cc75374cc3ull;
+
+static inline void wymum(uint64_t* a, uint64_t* b) {
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t wymix(uint64_t a, uint64_t b) {
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t dict_hash(const void* data, size_t len, uint64_t seed) {
+    const uint8_t* p = data;
+    uint64_t a, b;
+    seed ^= wymix(seed ^ P0, P1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + mid);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = wymix(read64(p) ^ P1, read64(p + 8) ^ seed);
+                seed1 = wymix(read64(p + 16) ^ P2, read64(p + 24) ^ seed1);
+                seed2 = wymix(read64(p + 32) ^ P3, read64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = wymix(read64(p) ^ P1, read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    a ^= P1;
+    b ^= seed;
+    wymum(&a, &b);
+    return wymix(a ^ P0 ^ len, b ^ P1);
+}
+
+/*
+ * Seed for a new dict, different for each dict and each run
+ * so collisions can not be precomputed (not cryptographic)
+ */
+static uint64_t random_seed(uintptr_t salt) {
+    static uint64_t counter = 0;
+    uint64_t count = __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint64_t seed = wymix((uint64_t)now.tv_sec ^ P0, (uint64_t)now.tv_nsec ^ P1);
+    return wymix(seed ^ salt, count ^ P2);
+}
+
+// Map a hash to [0, n) without division
+static inline size_t fastrange(uint64_t h, size_t n) {
+    return (size_t)(((__uint128_t)h * n) >> 64);
+}
+
+static inline int8_t hash_h2(uint64_t h) {
+    return h & 0x7F;
+}
+
+static inline size_t hash_h1(uint64_t h) {
+    return h >> 7;
+}
+
+// ===== GROUP MATCHING ===== //
+
+// bit i set if slot i of the group has control byte `c`
+static inline uint32_t group_match(const int8_t* group, int8_t c) {
+#if defined(__AVX2__)
+    __m256i ctrl = _mm256_loadu_si256((const __m256i*)group);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(c)));
+#elif defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DICT_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(group[i] == c) << i;
+    return mask;
+#endif
+}
+
+// bit i set if slot i of the group is EMPTY or DELETED
+static inline uint32_t group_match_free(const int8_t* group) {
+#if defined(__AVX2__)
+    return _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)group));
+#elif defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < DICT_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(group[i] < 0) << i;
+    return mask;
+#endif
+}
+
+static inline uint32_t group_match_empty(const int8_t* group) {
+    return group_match(group, CTRL_EMPTY);
+}
+
+#define MASK_FOR(bit, mask) \
+    for (uint32_t _m = (mask), bit; _m && (bit = __builtin_ctz(_m), 1); _m &= _m - 1)
+
+// ===== KEYS ===== //
+
+static char* arena_alloc(const struct gdata_allocator* allocator,
+                         struct dict_arena_chunk** arena, size_t size) {
+    struct dict_arena_chunk* chunk = *arena;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        size_t chunk_size = chunk ? 2*chunk->size : DICT_ARENA_MIN_CHUNK;
+        if (chunk_size > DICT_ARENA_MAX_CHUNK) chunk_size = DICT_ARENA_MAX_CHUNK;
+        if (chunk_size < size) chunk_size = size;
+
+        struct dict_arena_chunk* new_chunk = gdata_alloc(allocator, sizeof(*new_chunk) + chunk_size);
+        if (new_chunk == NULL)
+            return NULL;
+        *new_chunk = (struct dict_arena_chunk){.next = chunk, .size = chunk_size};
+        *arena = chunk = new_chunk;
+    }
+    char* result = chunk->data + chunk->used;
+    chunk->used += size;
+    return result;
+}
+
+static void arena_free(const struct gdata_allocator* allocator, struct dict_arena_chunk* arena) {
+    while (arena) {
+        struct dict_arena_chunk* next = arena->next;
+        gdata_free(allocator, arena, sizeof(*arena) + arena->size);
+        arena = next;
+    }
+}
+
+static inline const char* pair_key(const struct dict_pair* pair) {
+    return pair->len < DICT_INLINE_KEY_SIZE ? pair->key.inline_key : pair->key.ptr;
+}
+
+// the cached hash rejects almost every mismatch without reading the key
+static inline bool pair_key_equals(const struct dict_pair* pair, const char* key,
+                                   size_t len, uint64_t h) {
+    return pair->hash == h && pair->len == len && memcmp(pair_key(pair), key, len) == 0;
+}
+
+// Copy a key into the pair, long keys go to the arena (NUL terminated in both cases)
+static bool pair_set_key(const struct gdata_allocator* allocator, struct dict_pair* pair,
+                         struct dict_arena_chunk** arena, const char* key, size_t len) {
+    char* dest = pair->key.inline_key;
+    if (len >= DICT_INLINE_KEY_SIZE) {
+        dest = arena_alloc(allocator, arena, len + 1);
+        if (dest == NULL)
+            return false;
+        pair->key.ptr = dest;
+    }
+    memcpy(dest, key, len);
+    dest[len] = '\0';
+    pair->len = len;
+    return true;
+}
+
+// ===== TABLE ===== //
+
+/*
+ * Iterate over the probe sequence of a hash (triangular, visits every
+ * group once since the number of groups is a power of two)
+ */
+#define PROBE_FOR(group, capacity, h) \
+    for (size_t _groups = (capacity) / DICT_GROUP_WIDTH, _step = 0, \
+         group = hash_h1(h) & (_groups - 1); \
+         _step < _groups; \
+         group = (group + ++_step) & (_groups - 1))
+
+static inline size_t table_bytes(size_t capacity, const struct dict_entries* entries) {
+    size_t slot_size = entries ? sizeof(uint32_t) : sizeof(struct dict_pair);
+    return capacity * (slot_size + 1);
+}
+
+// @param entries: entries of an ordered dict, NULL for a table of pairs
+static bool table_alloc(const struct gdata_allocator* allocator, struct dict_table* table,
+                        size_t capacity, struct dict_entries* entries) {
+    size_t slot_size = entries ? sizeof(uint32_t) : sizeof(struct dict_pair);
+    char* block = gdata_alloc(allocator, table_bytes(capacity, entries));
+    if (block == NULL)
+        return false;
+    *table = (struct dict_table){
+        .pairs = entries ? NULL : (struct dict_pair*)block,
+        .index = entries ? (uint32_t*)block : NULL,
+        .entries = entries,
+        .ctrl = (int8_t*)(block + capacity * slot_size),
+        .capacity = capacity
+    };
+    memset(table->ctrl, CTRL_EMPTY, capacity);
+    return true;
+}
+
+static void table_free(const struct gdata_allocator* allocator, struct dict_table* table) {
+    arena_free(allocator, table->arena);
+    void* block = table->entries ? (void*)table->index : (void*)table->pairs;
+    gdata_free(allocator, block, table_bytes(table->capacity, table->entries));
+    *table = (struct dict_table){0};
+}
+
+static inline struct dict_pair* table_pair(const struct dict_table* table, size_t slot) {
+    return table->entries ? table->entries->at + table->index[slot] : table->pairs + slot;
+}
+
+// returns the slot of `key` or `capacity` if not found
+static size_t table_find(const struct dict_table* table, const char* key, size_t len, uint64_t h) {
+    int8_t h2 = hash_h2(h);
+    PROBE_FOR(group, table->capacity, h) {
+        const int8_t* ctrl = table->ctrl + group * DICT_GROUP_WIDTH;
+        MASK_FOR(bit, group_match(ctrl, h2)) {
+            size_t slot = group * DICT_GROUP_WIDTH + bit;
+            if (pair_key_equals(table_pair(table, slot), key, len, h))
+                return slot;
+        }
+        if (group_match_empty(ctrl))
+            break;
+    }
+    return table->capacity;
+}
+
+// first free slot in the probe sequence of `h`
+static size_t table_find_free(const struct dict_table* table, uint64_t h) {
+    PROBE_FOR(group, table->capacity, h) {
+        uint32_t mask = group_match_free(table->ctrl + group * DICT_GROUP_WIDTH);
+        if (mask)
+            return group * DICT_GROUP_WIDTH + __builtin_ctz(mask);
+    }
+    return table->capacity;
+}
+
+// take a free slot for hash `h`
+static size_t table_claim(struct dict_table* table, uint64_t h) {
+    size_t slot = table_find_free(table, h);
+    if (table->ctrl[slot] == CTRL_DELETED)
+        table->deleted--;
+    table->ctrl[slot] = hash_h2(h);
+    table->size++;
+    return slot;
+}
+
+static struct dict_pair* table_insert(struct dict_table* table, const struct dict_pair* pair) {
+    size_t slot = table_claim(table, pair->hash);
+    table->pairs[slot] = *pair;
+    return table->pairs + slot;
+}
+
+static void table_erase(struct dict_table* table, size_t slot) {
+    // A group that still has an EMPTY slot never made a probe go further,
+    // so the slot can be released instead of left as a tombstone
+    const int8_t* group = table->ctrl + slot / DICT_GROUP_WIDTH * DICT_GROUP_WIDTH;
+    if (group_match_empty(group)) {
+        table->ctrl[slot] = CTRL_EMPTY;
+    } else {
+        table->ctrl[slot] = CTRL_DELETED;
+        table->deleted++;
+    }
+    table->size--;
+}
+
+// ===== REHASHING ===== //
+
+static inline bool dict_is_rehashing(Dict dict) {
+    return dict->rehash_index != NOT_REHASHING;
+}
+
+static size_t dict_max_load(Dict dict, size_t capacity) {
+    return capacity * dict->grow;
+}
+
+// smallest capacity holding `num_elements` below the load factor `grow`
+static size_t capacity_for_load(size_t num_elements, float grow) {
+    size_t capacity = DICT_GROUP_WIDTH;
+    while ((size_t)(capacity * grow) < num_elements)
+        capacity *= 2;
+    return capacity;
+}
+
+static size_t capacity_for(Dict dict, size_t num_elements) {
+    return capacity_for_load(num_elements, dict->grow);
+}
+
+/*
+ * Move up to `steps` groups of ht[0] to ht[1].
+ * Moved slots are marked as DELETED so probes in ht[0] still work
+ */
+static void dict_rehash(Dict dict, size_t steps) {
+    if (!dict_is_rehashing(dict))
+        return;
+
+    struct dict_table *from = dict->ht, *to = dict->ht + 1;
+    size_t groups = from->capacity / DICT_GROUP_WIDTH;
+
+    while (steps-- && dict->rehash_index < groups) {
+        size_t base = dict->rehash_index++ * DICT_GROUP_WIDTH;
+        uint32_t full = ~group_match_free(from->ctrl + base);
+        MASK_FOR(bit, full & (uint32_t)((1ull << DICT_GROUP_WIDTH) - 1)) {
+            struct dict_pair* pair = table_pair(from, base + bit);
+            if (from->entries) {
+                to->index[table_claim(to, pair->hash)] = from->index[base + bit];
+                from->ctrl[base + bit] = CTRL_DELETED;
+                from->size--;
+                continue;
+            }
+            struct dict_pair* moved = table_insert(to, pair);
+            if (pair->len >= DICT_INLINE_KEY_SIZE &&
+                !pair_set_key(dict->allocator, moved, &to->arena, pair->key.ptr, pair->len)) {
+                // out of memory: the new table takes the old arena as is
+                struct dict_arena_chunk** tail = &to->arena;
+                while (*tail) tail = &(*tail)->next;
+                *tail = from->arena;
+                from->arena = NULL;
+            }
+            from->ctrl[base + bit] = CTRL_DELETED;
+            from->size--;
+        }
+    }
+
+    dict->update_keys = true;
+    if (dict->rehash_index == groups) {
+        table_free(dict->allocator, from);
+        dict->ht[0] = dict->ht[1];
+        dict->ht[1] = (struct dict_table){0};
+        dict->rehash_index = NOT_REHASHING;
+        dict->version++;
+    }
+}
+
+static void dict_start_rehash(Dict dict, size_t capacity) {
+    if (table_alloc(dict->allocator, dict->ht + 1, capacity, dict->entries)) {
+        dict->rehash_index = 0;
+        dict->version++;
+    }
+}
+
+// Make room for one more element, returns the table to insert into
+static struct dict_table* dict_reserve_one(Dict dict) {
+    if (dict_is_rehashing(dict)) {
+        struct dict_table* to = dict->ht + 1;
+        if (to->size + to->deleted < dict_max_load(dict, to->capacity))
+            return to;
+        // the new table filled up before the end of rehash
+        dict_rehash(dict, SIZE_MAX);
+    }
+
+    struct dict_table* table = dict->ht;
+    if (table->size + table->deleted < dict_max_load(dict, table->capacity))
+        return table;
+
+    // tables with too many tombstones are cleaned without growing
+    dict_start_rehash(dict, capacity_for(dict, 2*(table->size + 1)));
+    return dict_is_rehashing(dict) ? dict->ht + 1 : NULL;
+}
+
+static void dict_check_shrink(Dict dict) {
+    struct dict_table* table = dict->ht;
+    if (dict_is_rehashing(dict) || table->size >= table->capacity * dict->shrink)
+        return;
+    size_t capacity = capacity_for(dict, 2*table->size);
+    if (capacity < table->capacity)
+        dict_start_rehash(dict, capacity);
+}
+
+/*
+ * Remove the holes of the entries array, keeping the order, and rebuild
+ * the index. Long keys move to a new arena, like in dict_rehash()
+ */
+static void dict_compact(Dict dict) {
+    dict_rehash(dict, SIZE_MAX);
+    struct dict_entries* entries = dict->entries;
+    struct dict_arena_chunk* arena = NULL;
+    bool copy_keys = true;
+
+    size_t size = 0;
+    for (size_t i = 0; i < entries->size; i++) {
+        struct dict_pair* pair = entries->at + i;
+        if (pair->len == DICT_ENTRY_REMOVED)
+            continue;
+        if (copy_keys && pair->len >= DICT_INLINE_KEY_SIZE)
+            copy_keys = pair_set_key(dict->allocator, pair, &arena, pair->key.ptr, pair->len);
+        entries->at[size++] = *pair;
+    }
+    if (copy_keys) {
+        arena_free(dict->allocator, entries->arena);
+        entries->arena = arena;
+    } else {
+        // out of memory: keys not copied are still in the old arena
+        struct dict_arena_chunk** tail = &arena;
+        while (*tail) tail = &(*tail)->next;
+        *tail = entries->arena;
+        entries->arena = arena;
+    }
+    entries->size = size;
+    entries->deleted = 0;
+    entries->version++;
+
+    struct dict_table* table = dict->ht;
+    memset(table->ctrl, CTRL_EMPTY, table->capacity);
+    table->size = 0;
+    table->deleted = 0;
+    for (size_t i = 0; i < size; i++)
+        table->index[table_claim(table, entries->at[i].hash)] = i;
+}
+
+// Make room for one more entry in an ordered dict
+static bool dict_reserve_entry(Dict dict) {
+    struct dict_entries* entries = dict->entries;
+    if (entries->size < entries->alloc)
+        return true;
+    if (entries->deleted > entries->size / 4) {
+        dict_compact(dict);
+        return true;
+    }
+
+    size_t alloc = entries->alloc ? 2*entries->alloc : DICT_GROUP_WIDTH;
+    if (alloc > UINT32_MAX)
+        return false;
+    struct dict_pair* at = gdata_realloc(dict->allocator, entries->at,
+                                         entries->alloc * sizeof(*at), alloc * sizeof(*at));
+    if (at == NULL)
+        return false;
+    entries->at = at;
+    entries->alloc = alloc;
+    return true;
+}
+
+/*
+ * Find the pair of `key` in both tables.
+ * @param slot: if not NULL, receives the slot in the returned table
+ */
+static struct dict_table* dict_find(Dict dict, const char* key, size_t len, uint64_t h, size_t* slot) {
+    for (int i = 0; i < 1 + dict_is_rehashing(dict); i++) {
+        size_t found = table_find(dict->ht + i, key, len, h);
+        if (found != dict->ht[i].capacity) {
+            if (slot) *slot = found;
+            return dict->ht + i;
+        }
+    }
+    return NULL;
+}
+
+// ===== FILTER ===== //
+
+/*
+ * Blocked counting Bloom filter: each key sets DICT_FILTER_HASHES counters
+ * of a single block, so a lookup reads one cache line. Counters saturate
+ * at 15 and are never decremented after that, which keeps removals safe
+ */
+struct dict_filter {
+    uint8_t* blocks; // aligned in `memory`
+    void* memory;
+    size_t num_blocks;
+    size_t capacity; // number of keys it was sized for
+    size_t lookups;
+    size_t negatives;
+    size_t false_positives;
 };
 
-// djb2 hash function
-static size_t hash(unsigned char *str)
-{
-    size_t hash = 5381;
-    int c;
+static inline uint8_t* filter_block(const struct dict_filter* filter, uint64_t h) {
+    return filter->blocks + fastrange(h, filter->num_blocks) * DICT_FILTER_BLOCK_SIZE;
+}
 
-    while (c = *str++)
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+// counter positions come from all the bits of the hash, not only those picking the block
+#define FILTER_COUNTERS_FOR(counter, h) \
+    for (uint64_t _x = (h) * P3, _i = 0, counter; \
+         _i < DICT_FILTER_HASHES && (counter = _x >> (57 - 7*_i) & 127, 1); _i++)
 
-    return hash;
+static inline bool filter_may_contain(const struct dict_filter* filter, uint64_t h) {
+    const uint8_t* block = filter_block(filter, h);
+    FILTER_COUNTERS_FOR(c, h) {
+        if ((block[c >> 1] >> (c & 1) * 4 & 0xF) == 0)
+            return false;
+    }
+    return true;
 }
 
+static void filter_add(struct dict_filter* filter, uint64_t h) {
+    uint8_t* block = filter_block(filter, h);
+    FILTER_COUNTERS_FOR(c, h) {
+        unsigned shift = (c & 1) * 4;
+        if ((block[c >> 1] >> shift & 0xF) != 0xF)
+            block[c >> 1] += 1 << shift;
+    }
+}
+
+static void filter_remove(struct dict_filter* filter, uint64_t h) {
+    uint8_t* block = filter_block(filter, h);
+    FILTER_COUNTERS_FOR(c, h) {
+        unsigned shift = (c & 1) * 4;
+        if ((block[c >> 1] >> shift & 0xF) != 0xF)
+            block[c >> 1] -= 1 << shift;
+    }
+}
+
+static inline size_t filter_bytes(size_t num_blocks) {
+    return (num_blocks + 1) * DICT_FILTER_BLOCK_SIZE - 1;
+}
+
+// Fill a new filter for `capacity` keys with the keys of the dict
+static bool dict_build_filter(Dict dict, size_t capacity) {
+    struct dict_filter* filter = dict->filter;
+    size_t num_blocks = capacity / DICT_FILTER_KEYS_PER_BLOCK + 1;
+    // allocators give no alignment guarantee, the blocks are aligned inside
+    void* memory = gdata_alloc(dict->allocator, filter_bytes(num_blocks));
+    if (memory == NULL)
+        return false;
+    uintptr_t blocks = ((uintptr_t)memory + DICT_FILTER_BLOCK_SIZE - 1) & ~(uintptr_t)(DICT_FILTER_BLOCK_SIZE - 1);
+    memset((void*)blocks, 0, num_blocks * DICT_FILTER_BLOCK_SIZE);
+    gdata_free(dict->allocator, filter->memory, filter_bytes(filter->num_blocks));
+    filter->memory = memory;
+    filter->blocks = (uint8_t*)blocks;
+    filter->num_blocks = num_blocks;
+    filter->capacity = capacity;
+
+    for (int t = 0; t < 1 + dict_is_rehashing(dict); t++) {
+        const struct dict_table* table = dict->ht + t;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->ctrl[i] >= 0)
+                filter_add(filter, table_pair(table, i)->hash);
+        }
+    }
+    return true;
+}
+
+// true if the filter proves `h` is not in the dict
+static inline bool dict_filter_rejects(Dict dict, uint64_t h) {
+    struct dict_filter* filter = dict->filter;
+    if (filter == NULL)
+        return false;
+    filter->lookups++;
+    if (filter_may_contain(filter, h))
+        return false;
+    filter->negatives++;
+    return true;
+}
+
+static inline void dict_filter_missed(Dict dict) {
+    if (dict->filter)
+        dict->filter->false_positives++;
+}
+
+static void dict_filter_added(Dict dict, uint64_t h) {
+    struct dict_filter* filter = dict->filter;
+    if (filter == NULL)
+        return;
+    filter_add(filter, h);
+    // too full for its size, rebuilt bigger (or kept if out of memory)
+    if (dict_size(dict) > 2*filter->capacity)
+        dict_build_filter(dict, 2*dict_size(dict));
+}
+
+bool dict_enable_filter(Dict dict, size_t expected_size) {
+    if (dict->image)
+        return false;
+    if (dict->filter)
+        return true;
+    dict->filter = gdata_calloc(dict->allocator, 1, sizeof(*dict->filter));
+    if (dict->filter == NULL)
+        return false;
+    if (expected_size < dict_size(dict))
+        expected_size = dict_size(dict);
+    if (!dict_build_filter(dict, expected_size)) {
+        gdata_free(dict->allocator, dict->filter, sizeof(*dict->filter));
+        dict->filter = NULL;
+        return false;
+    }
+    return true;
+}
+
+DictFilterStats dict_filter_stats(Dict dict) {
+    struct dict_filter* filter = dict->filter;
+    if (filter == NULL)
+        return (DictFilterStats){0};
+    size_t misses = filter->negatives + filter->false_positives;
+    return (DictFilterStats){
+        .lookups = filter->lookups,
+        .negatives = filter->negatives,
+        .false_positives = filter->false_positives,
+        .false_positive_rate = misses ? (double)filter->false_positives / misses : 0.0,
+        .memory = filter->num_blocks * DICT_FILTER_BLOCK_SIZE,
+    };
+}
+
+// ===== SNAPSHOTS ===== //
+
+// "!GDICT01" in little endian, images of other byte orders are rejected
+#define DICT_IMAGE_MAGIC 0x3130544349444721ull
+
+// Alignment of values in the image
+#define DICT_IMAGE_ALIGN 16
+
+/*
+ * Flat image written by dict_save(). References are offsets from the
+ * start of the file, so it works wherever it is mapped:
+ *   header | ctrl[capacity] | entries[capacity] | keys and values
+ * ctrl and entries are probed exactly like a dict_table
+ */
+struct dict_image {
+    uint64_t magic;
+    uint32_t group_width;
+    uint32_t entry_size;
+    uint64_t seed;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t file_size;
+};
+
+struct dict_image_entry {
+    uint64_t hash;
+    uint64_t key;   // offset of the NUL terminated key
+    uint64_t len;
+    uint64_t value; // offset of the value, 0 for NULL
+};
+
+static inline const int8_t* image_ctrl(const struct dict_image* image) {
+    return (const int8_t*)(image + 1);
+}
+
+static inline const struct dict_image_entry* image_entries(const struct dict_image* image) {
+    return (const struct dict_image_entry*)(image_ctrl(image) + image->capacity);
+}
+
+static inline size_t image_align(size_t offset) {
+    return (offset + DICT_IMAGE_ALIGN - 1) & ~(size_t)(DICT_IMAGE_ALIGN - 1);
+}
+
+static void* image_get(const struct dict_image* image, const char* key, size_t len, uint64_t h) {
+    const struct dict_image_entry* entries = image_entries(image);
+    int8_t h2 = hash_h2(h);
+    PROBE_FOR(group, image->capacity, h) {
+        const int8_t* ctrl = image_ctrl(image) + group * DICT_GROUP_WIDTH;
+        MASK_FOR(bit, group_match(ctrl, h2)) {
+            const struct dict_image_entry* entry = entries + group * DICT_GROUP_WIDTH + bit;
+            if (entry->hash == h && entry->len == len &&
+                memcmp((const char*)image + entry->key, key, len) == 0)
+                return entry->value ? (char*)image + entry->value : NULL;
+        }
+        if (group_match_empty(ctrl))
+            break;
+    }
+    return NULL;
+}
+
+static bool image_iter_next(const struct dict_image* image, DictIter* it) {
+    const struct dict_image_entry* entries = image_entries(image);
+    while (it->internal.slot < image->capacity) {
+        size_t slot = it->internal.slot++;
+        if (image_ctrl(image)[slot] < 0)
+            continue;
+        it->key = (const char*)image + entries[slot].key;
+        it->len = entries[slot].len;
+        it->value = entries[slot].value ? (char*)image + entries[slot].value : NULL;
+        it->destructor = NULL;
+        return true;
+    }
+    it->internal.done = true;
+    return false;
+}
+
+// write `size` bytes of data at `offset`, zero filling the gap from `*written`
+static bool write_at(FILE* file, size_t* written, size_t offset, const void* data, size_t size) {
+    static const char zeros[DICT_IMAGE_ALIGN];
+    size_t gap = offset - *written;
+    if (fwrite(zeros, 1, gap, file) != gap || fwrite(data, 1, size, file) != size)
+        return false;
+    *written = offset + size;
+    return true;
+}
+
+/*
+ * Elements are placed in a table of their own and then written slot by
+ * slot, each key followed by its value. `sources` holds the key and value
+ * pointers while `entries` holds their offsets in the file
+ */
+static bool write_image(FILE* file, struct dict_image* header, int8_t* ctrl,
+                        struct dict_image_entry* entries, const void** sources,
+                        size_t (*value_size)(const void*)) {
+    size_t capacity = header->capacity;
+    size_t offset = sizeof(*header) + capacity * (1 + sizeof(*entries));
+    for (size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] < 0)
+            continue;
+        const void* value = sources[2*i + 1];
+        entries[i].key = offset;
+        offset += entries[i].len + 1;
+        if (value) {
+            entries[i].value = offset = image_align(offset);
+            offset += value_size ? value_size(value) : strlen(value) + 1;
+        }
+    }
+    header->file_size = offset;
+
+    size_t written = 0;
+    if (!write_at(file, &written, 0, header, sizeof(*header)) ||
+        !write_at(file, &written, written, ctrl, capacity) ||
+        !write_at(file, &written, written, entries, capacity * sizeof(*entries)))
+        return false;
+
+    for (size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] < 0)
+            continue;
+        const void* value = sources[2*i + 1];
+        if (!write_at(file, &written, entries[i].key, sources[2*i], entries[i].len + 1))
+            return false;
+        if (value && !write_at(file, &written, entries[i].value, value,
+                               value_size ? value_size(value) : strlen(value) + 1))
+            return false;
+    }
+    return true;
+}
+
+bool dict_save(Dict dict, const char* path, size_t (*value_size)(const void* value)) {
+    struct dict_image header = {
+        .magic = DICT_IMAGE_MAGIC,
+        .group_width = DICT_GROUP_WIDTH,
+        .entry_size = sizeof(struct dict_image_entry),
+        .seed = dict->seed,
+        .size = dict_size(dict),
+        .capacity = capacity_for(dict, dict_size(dict)),
+    };
+    size_t capacity = header.capacity;
+    const struct gdata_allocator* allocator = dict->allocator;
+    int8_t* ctrl = gdata_alloc(allocator, capacity);
+    struct dict_image_entry* entries = gdata_calloc(allocator, capacity, sizeof(*entries));
+    const void** sources = gdata_alloc(allocator, 2 * capacity * sizeof(*sources));
+    bool result = false;
+    if (ctrl == NULL || entries == NULL || sources == NULL)
+        goto end;
+
+    memset(ctrl, CTRL_EMPTY, capacity);
+    for (DictIter it = dict_iter_begin(dict); dict_iter_next(dict, &it);) {
+        uint64_t h = dict_hash(it.key, it.len, dict->seed);
+        PROBE_FOR(group, capacity, h) {
+            uint32_t mask = group_match_free(ctrl + group * DICT_GROUP_WIDTH);
+            if (mask) {
+                size_t slot = group * DICT_GROUP_WIDTH + __builtin_ctz(mask);
+                ctrl[slot] = hash_h2(h);
+                entries[slot] = (struct dict_image_entry){.hash = h, .len = it.len};
+                sources[2*slot] = it.key;
+                sources[2*slot + 1] = it.value;
+                break;
+            }
+        }
+    }
+
+    // written aside and renamed, so processes mapping the old file are not affected
+    size_t path_len = strlen(path);
+    char* tmp_path = gdata_alloc(allocator, path_len + 5);
+    if (tmp_path == NULL)
+        goto end;
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (file) {
+        result = write_image(file, &header, ctrl, entries, sources, value_size);
+        result = fclose(file) == 0 && result;
+        result = result && rename(tmp_path, path) == 0;
+        if (!result)
+            remove(tmp_path);
+    }
+    gdata_free(allocator, tmp_path, path_len + 5);
+
+end:
+    gdata_free(allocator, ctrl, capacity);
+    gdata_free(allocator, entries, capacity * sizeof(*entries));
+    gdata_free(allocator, sources, 2 * capacity * sizeof(*sources));
+    return result;
+}
+
+/*
+ * Every full slot must reference keys and values inside the file, so a
+ * truncated or corrupted image is rejected at open instead of being read
+ * out of bounds later by lookups and iterators
+ */
+static bool image_entries_are_valid(const struct dict_image* image, size_t file_size) {
+    size_t capacity = image->capacity;
+    size_t data_start = sizeof(*image) + capacity * (1 + sizeof(struct dict_image_entry));
+    const int8_t* ctrl = image_ctrl(image);
+    const struct dict_image_entry* entries = image_entries(image);
+    size_t full = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] < 0)
+            continue;
+        const struct dict_image_entry* entry = entries + i;
+        if (entry->key < data_start || entry->key >= file_size ||
+            entry->len >= file_size - entry->key ||
+            ((const char*)image)[entry->key + entry->len] != '\0')
+            return false;
+        if (entry->value && (entry->value < data_start || entry->value >= file_size))
+            return false;
+        full++;
+    }
+    return full == image->size;
+}
+
+static bool image_is_valid(const struct dict_image* image, size_t file_size) {
+    if (file_size < sizeof(*image))
+        return false;
+    size_t capacity = image->capacity;
+    return image->magic == DICT_IMAGE_MAGIC &&
+           image->group_width == DICT_GROUP_WIDTH &&
+           image->entry_size == sizeof(struct dict_image_entry) &&
+           image->file_size == file_size &&
+           capacity >= DICT_GROUP_WIDTH && (capacity & (capacity - 1)) == 0 &&
+           capacity < file_size / (1 + sizeof(struct dict_image_entry)) &&
+           image_entries_are_valid(image, file_size);
+}
+
+Dict dict_open_mmap(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    Dict result = NULL;
+    const struct gdata_allocator* allocator = gdata_default_allocator();
+    if (image_is_valid(map, st.st_size))
+        result = gdata_alloc(allocator, sizeof(*result));
+    if (result == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    *result = (struct dict){
+        .seed = ((const struct dict_image*)map)->seed,
+        .rehash_index = NOT_REHASHING,
+        .grow = DICT_DEFAULT_GROW,
+        .shrink = DICT_DEFAULT_SHRINK,
+        .image = map,
+        .image_size = st.st_size,
+        .allocator = allocator,
+    };
+    return result;
+}
+
+// ===== DICT ===== //
+
 Dict dict_create(size_t size) {
-    Dict result = malloc(sizeof(*result));
-    result->table = calloc(size, sizeof(struct dict_pair*));
-    result->table_size = size;
-    result->num_elements = 0;
-    result->keys = NULL;
-    result->update_keys = false;
+    return dict_create_with(gdata_default_allocator(), size);
+}
+
+Dict dict_create_with(const struct gdata_allocator* allocator, size_t size) {
+    Dict result = gdata_alloc(allocator, sizeof(*result));
+    if (result) {
+        *result = (struct dict){
+            .seed = random_seed((uintptr_t)result),
+            .rehash_index = NOT_REHASHING,
+            .grow = DICT_DEFAULT_GROW,
+            .shrink = DICT_DEFAULT_SHRINK,
+            .allocator = allocator,
+        };
+        if (!table_alloc(allocator, result->ht, capacity_for(result, size), NULL)) {
+            gdata_free(allocator, result, sizeof(*result));
+            return NULL;
+        }
+    }
+    return result;
+}
+
+Dict dict_create_ordered(size_t size) {
+    return dict_create_ordered_with(gdata_default_allocator(), size);
+}
+
+Dict dict_create_ordered_with(const struct gdata_allocator* allocator, size_t size) {
+    Dict result = dict_create_with(allocator, 0);
+    if (result == NULL)
+        return NULL;
+    struct dict_entries* entries = gdata_calloc(allocator, 1, sizeof(*entries));
+    struct dict_table table;
+    if (entries == NULL || !table_alloc(allocator, &table, capacity_for(result, size), entries)) {
+        gdata_free(allocator, entries, sizeof(*entries));
+        dict_delete(result);
+        return NULL;
+    }
+    table_free(allocator, result->ht);
+    result->ht[0] = table;
+    result->entries = entries;
     return result;
 }
 
 void dict_delete(Dict dict) {
+    const struct gdata_allocator* allocator = dict->allocator;
+    if (dict->image) {
+        munmap((void*)dict->image, dict->image_size);
+        gdata_free(allocator, dict->keys, dict->keys_alloc * sizeof(char*));
+        gdata_free(allocator, dict, sizeof(*dict));
+        return;
+    }
     dict_clear(dict);
-    free(dict->table);
-    free(dict);
+    table_free(allocator, dict->ht);
+    if (dict->entries) {
+        gdata_free(allocator, dict->entries->at, dict->entries->alloc * sizeof(struct dict_pair));
+        gdata_free(allocator, dict->entries, sizeof(*dict->entries));
+    }
+    if (dict->filter) {
+        gdata_free(allocator, dict->filter->memory, filter_bytes(dict->filter->num_blocks));
+        gdata_free(allocator, dict->filter, sizeof(*dict->filter));
+    }
+    gdata_free(allocator, dict, sizeof(*dict));
 }
 
 size_t dict_size(Dict dict) {
-    return dict->num_elements;
+    if (dict->image)
+        return dict->image->size;
+    return dict->ht[0].size + dict->ht[1].size;
 }
 
-void dict_set(Dict dict, const char* key, void* value, void(*destructor)(void*)) {
-    size_t index = hash((unsigned char*)key) % dict->table_size;
+size_t dict_capacity(Dict dict) {
+    if (dict->image)
+        return dict->image->capacity;
+    return dict->ht[0].capacity + dict->ht[1].capacity;
+}
 
-    for (struct dict_pair* node = dict->table[index]; node; node = node->next) {
-        if (strcmp(node->key, key) == 0) {
-            node->value = value;
-            node->del = destructor;
-            return;
-        }
+void dict_set_load_factor(Dict dict, float grow, float shrink) {
+    if (grow < 0.25f) grow = 0.25f;
+    if (grow > 0.9375f) grow = 0.9375f;
+    if (shrink < 0.0f) shrink = 0.0f;
+    if (shrink > grow/4) shrink = grow/4;
+    dict->grow = grow;
+    dict->shrink = shrink;
+}
+
+static void dict_set_hashed(Dict dict, const char* key, size_t len, uint64_t h,
+                            void* value, void(*destructor)(void*)) {
+    if (dict->image)
+        return;
+
+    size_t slot;
+    struct dict_table* table = dict_find(dict, key, len, h, &slot);
+
+    if (table) {
+        table_pair(table, slot)->value = value;
+        table_pair(table, slot)->del = destructor;
+        return;
     }
 
-    struct dict_pair* new_node = malloc(sizeof(struct dict_pair));
-    if (new_node) {
-        strncpy(new_node->key, key, DICT_MAX_KEY_SIZE);
-        new_node->value = value;
-        new_node->del = destructor;
-        new_node->next = dict->table[index];
+    // (compacting entries rebuilds the tables)
+    if (dict->entries && !dict_reserve_entry(dict))
+        return;
+    table = dict_reserve_one(dict);
+    if (table == NULL)
+        return;
 
-        dict->num_elements++;
-        dict->table[index] = new_node;
-        dict->update_keys = true;
+    struct dict_pair pair = {.hash = h, .value = value, .del = destructor};
+    if (dict->entries) {
+        struct dict_entries* entries = dict->entries;
+        if (!pair_set_key(dict->allocator, &pair, &entries->arena, key, len))
+            return;
+        entries->at[entries->size] = pair;
+        table->index[table_claim(table, h)] = entries->size++;
+    } else {
+        if (!pair_set_key(dict->allocator, &pair, &table->arena, key, len))
+            return;
+        table_insert(table, &pair);
     }
+    dict_filter_added(dict, h);
+    dict->update_keys = true;
+}
+
+void dict_set(Dict dict, const char* key, void* value, void(*destructor)(void*)) {
+    dict_rehash(dict, DICT_REHASH_STEP);
+
+    size_t len = strlen(key);
+    dict_set_hashed(dict, key, len, dict_hash(key, len, dict->seed), value, destructor);
 }
 
 void dict_setobj(Dict dict, const char* key, void* value) {
@@ -82,62 +1143,944 @@ void dict_setref(Dict dict, const char* key, void* value) {
 }
 
 void* dict_get(Dict dict, const char* key) {
-    size_t index = hash((unsigned char*)key) % dict->table_size;
-    struct dict_pair* node = dict->table[index];
-    while(node) {
-        if (strcmp(node->key, key) == 0)
-            return node->value;
-        node = node->next;
+    return dict_get_len(dict, key, strlen(key));
+}
+
+void* dict_get_len(Dict dict, const char* key, size_t len) {
+    dict_rehash(dict, DICT_REHASH_STEP);
+
+    size_t slot;
+    uint64_t h = dict_hash(key, len, dict->seed);
+    if (dict->image)
+        return image_get(dict->image, key, len, h);
+    if (dict_filter_rejects(dict, h))
+        return NULL;
+    struct dict_table* table = dict_find(dict, key, len, h, &slot);
+    if (table == NULL) {
+        dict_filter_missed(dict);
+        return NULL;
+    }
+    return table_pair(table, slot)->value;
+}
+
+// ===== BATCHES ===== //
+
+struct dict_batch {
+    size_t len[DICT_BATCH_SIZE];
+    uint64_t hash[DICT_BATCH_SIZE];
+};
+
+/*
+ * Hash a batch of keys and prefetch what their lookup will read:
+ * first the control bytes of each home group, then the pair
+ * of the first candidate slot (once its group is in cache)
+ */
+static void dict_batch_prefetch(Dict dict, struct dict_batch* batch,
+                                const char** keys, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        batch->len[i] = strlen(keys[i]);
+        batch->hash[i] = dict_hash(keys[i], batch->len[i], dict->seed);
+        if (dict->filter)
+            __builtin_prefetch(filter_block(dict->filter, batch->hash[i]));
+        for (int t = 0; t < 1 + dict_is_rehashing(dict); t++) {
+            const struct dict_table* table = dict->ht + t;
+            size_t group = hash_h1(batch->hash[i]) & (table->capacity / DICT_GROUP_WIDTH - 1);
+            __builtin_prefetch(table->ctrl + group * DICT_GROUP_WIDTH);
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (int t = 0; t < 1 + dict_is_rehashing(dict); t++) {
+            const struct dict_table* table = dict->ht + t;
+            size_t group = hash_h1(batch->hash[i]) & (table->capacity / DICT_GROUP_WIDTH - 1);
+            uint32_t mask = group_match(table->ctrl + group * DICT_GROUP_WIDTH, hash_h2(batch->hash[i]));
+            if (mask == 0)
+                continue;
+            size_t slot = group * DICT_GROUP_WIDTH + __builtin_ctz(mask);
+            if (table->entries)
+                __builtin_prefetch(table->index + slot);
+            else
+                __builtin_prefetch(table->pairs + slot);
+        }
+    }
+}
+
+void dict_get_many(Dict dict, const char** keys, size_t n, void** values) {
+    if (dict->image) {
+        for (size_t i = 0; i < n; i++)
+            values[i] = dict_get(dict, keys[i]);
+        return;
+    }
+
+    struct dict_batch batch;
+    for (size_t done = 0; done < n; done += DICT_BATCH_SIZE) {
+        size_t count = n - done < DICT_BATCH_SIZE ? n - done : DICT_BATCH_SIZE;
+        dict_rehash(dict, DICT_REHASH_STEP);
+        dict_batch_prefetch(dict, &batch, keys + done, count);
+
+        for (size_t i = 0; i < count; i++) {
+            size_t slot;
+            const struct dict_table* table = NULL;
+            if (!dict_filter_rejects(dict, batch.hash[i])) {
+                table = dict_find(dict, keys[done + i], batch.len[i], batch.hash[i], &slot);
+                if (table == NULL)
+                    dict_filter_missed(dict);
+            }
+            values[done + i] = table ? table_pair(table, slot)->value : NULL;
+        }
+    }
+}
+
+void dict_set_many(Dict dict, const char** keys, void** values, size_t n,
+                   void(*destructor)(void*)) {
+    struct dict_batch batch;
+    for (size_t done = 0; done < n; done += DICT_BATCH_SIZE) {
+        size_t count = n - done < DICT_BATCH_SIZE ? n - done : DICT_BATCH_SIZE;
+        dict_rehash(dict, DICT_REHASH_STEP);
+        dict_batch_prefetch(dict, &batch, keys + done, count);
+
+        for (size_t i = 0; i < count; i++)
+            dict_set_hashed(dict, keys[done + i], batch.len[i], batch.hash[i],
+                            values[done + i], destructor);
+    }
+}
+
+// ===== BULK BUILD ===== //
+
+// Partitions per thread, more partitions balance the work better
+#define DICT_BULK_PARTS_PER_THREAD 8
+
+// Keys given to each thread at least, fewer keys do not start threads
+#define DICT_BULK_MIN_PARALLEL 4096
+
+// Most threads started by dict_build_bulk()
+#define DICT_BULK_MAX_THREADS 256
+
+/*
+ * Keys are hashed and partitioned by the range of home groups they fall
+ * in. Each partition is filled by a single thread, which only writes to
+ * the groups of its range: probes leaving the range are finished by the
+ * calling thread afterwards, when no other thread writes to the table
+ */
+struct dict_bulk {
+    Dict dict;
+    const char** keys;
+    void** values;
+    void(*destructor)(void*);
+    size_t n;
+    size_t num_threads;
+    size_t num_parts;
+    size_t* lens;
+    uint64_t* hashes;
+    size_t* counts;     // keys of each thread in each partition, then scatter offsets
+    size_t* part_start; // first key of each partition in `order`
+    size_t* order;      // keys sorted by partition
+    size_t next_part;
+};
+
+struct dict_bulk_worker {
+    struct dict_bulk* bulk;
+    size_t id;
+    size_t size;
+    struct dict_arena_chunk* arena;
+    size_t* overflow;
+    size_t num_overflow;
+    size_t alloc_overflow;
+    bool failed;
+};
+
+static inline size_t bulk_part(const struct dict_bulk* bulk, uint64_t h) {
+    size_t groups = bulk->dict->ht[0].capacity / DICT_GROUP_WIDTH;
+    return (hash_h1(h) & (groups - 1)) * bulk->num_parts / groups;
+}
+
+static void* bulk_hash(void* arg) {
+    struct dict_bulk_worker* worker = arg;
+    struct dict_bulk* bulk = worker->bulk;
+    size_t* counts = bulk->counts + worker->id * bulk->num_parts;
+    size_t end = (worker->id + 1) * bulk->n / bulk->num_threads;
+    for (size_t i = worker->id * bulk->n / bulk->num_threads; i < end; i++) {
+        bulk->lens[i] = strlen(bulk->keys[i]);
+        bulk->hashes[i] = dict_hash(bulk->keys[i], bulk->lens[i], bulk->dict->seed);
+        counts[bulk_part(bulk, bulk->hashes[i])]++;
     }
     return NULL;
 }
 
-void dict_remove(Dict dict, const char* key) {
-    size_t index = hash((unsigned char*)key) % dict->table_size;
-    struct dict_pair* a = dict->table[index], *b = a;
+static void* bulk_scatter(void* arg) {
+    struct dict_bulk_worker* worker = arg;
+    struct dict_bulk* bulk = worker->bulk;
+    size_t* offsets = bulk->counts + worker->id * bulk->num_parts;
+    size_t end = (worker->id + 1) * bulk->n / bulk->num_threads;
+    for (size_t i = worker->id * bulk->n / bulk->num_threads; i < end; i++)
+        bulk->order[offsets[bulk_part(bulk, bulk->hashes[i])]++] = i;
+    return NULL;
+}
+
+/*
+ * Insert key `i` probing only groups in [first, last).
+ * @return false if the probe left the range
+ */
+static bool bulk_insert(struct dict_bulk_worker* worker, size_t i, size_t first, size_t last) {
+    struct dict_bulk* bulk = worker->bulk;
+    struct dict_table* table = bulk->dict->ht;
+    const char* key = bulk->keys[i];
+    size_t len = bulk->lens[i];
+    uint64_t h = bulk->hashes[i];
+    int8_t h2 = hash_h2(h);
+
+    PROBE_FOR(group, table->capacity, h) {
+        if (group < first || group >= last)
+            return false;
+        int8_t* ctrl = table->ctrl + group * DICT_GROUP_WIDTH;
+        MASK_FOR(bit, group_match(ctrl, h2)) {
+            struct dict_pair* pair = table->pairs + group * DICT_GROUP_WIDTH + bit;
+            if (pair_key_equals(pair, key, len, h)) {
+                pair->value = bulk->values[i];
+                return true;
+            }
+        }
+        uint32_t empty = group_match_empty(ctrl);
+        if (empty) {
+            size_t slot = group * DICT_GROUP_WIDTH + __builtin_ctz(empty);
+            struct dict_pair pair = {.hash = h, .value = bulk->values[i], .del = bulk->destructor};
+            if (!pair_set_key(bulk->dict->allocator, &pair, &worker->arena, key, len)) {
+                worker->failed = true;
+                return true;
+            }
+            table->pairs[slot] = pair;
+            table->ctrl[slot] = h2;
+            worker->size++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* bulk_fill(void* arg) {
+    struct dict_bulk_worker* worker = arg;
+    struct dict_bulk* bulk = worker->bulk;
+    size_t groups = bulk->dict->ht[0].capacity / DICT_GROUP_WIDTH;
+    size_t part;
+    while ((part = __atomic_fetch_add(&bulk->next_part, 1, __ATOMIC_RELAXED)) < bulk->num_parts) {
+        // the groups whose keys are in this partition, see bulk_part()
+        size_t first = (part * groups + bulk->num_parts - 1) / bulk->num_parts;
+        size_t last = ((part + 1) * groups + bulk->num_parts - 1) / bulk->num_parts;
+
+        for (size_t k = bulk->part_start[part]; k < bulk->part_start[part + 1]; k++) {
+            size_t i = bulk->order[k];
+            if (bulk_insert(worker, i, first, last))
+                continue;
+            if (worker->num_overflow == worker->alloc_overflow) {
+                size_t alloc = worker->alloc_overflow ? 2*worker->alloc_overflow : 64;
+                size_t* overflow = gdata_realloc(bulk->dict->allocator, worker->overflow,
+                                                 worker->alloc_overflow * sizeof(size_t),
+                                                 alloc * sizeof(size_t));
+                if (overflow == NULL) {
+                    worker->failed = true;
+                    return NULL;
+                }
+                worker->overflow = overflow;
+                worker->alloc_overflow = alloc;
+            }
+            worker->overflow[worker->num_overflow++] = i;
+        }
+    }
+    return NULL;
+}
+
+Dict dict_build_bulk(const char** keys, void** values, size_t n, size_t num_threads,
+                     void(*destructor)(void*)) {
+    return dict_build_bulk_with(gdata_default_allocator(), keys, values, n, num_threads, destructor);
+}
+
+Dict dict_build_bulk_with(const struct gdata_allocator* allocator, const char** keys,
+                          void** values, size_t n, size_t num_threads, void(*destructor)(void*)) {
+    size_t max_threads = n / DICT_BULK_MIN_PARALLEL;
+    if (max_threads > DICT_BULK_MAX_THREADS)
+        max_threads = DICT_BULK_MAX_THREADS;
+    num_threads = gdata_thread_count(num_threads, max_threads);
+
+    Dict dict = dict_create_with(allocator, n);
+    if (dict == NULL)
+        return NULL;
+    size_t groups = dict->ht[0].capacity / DICT_GROUP_WIDTH;
+    size_t num_parts = num_threads * DICT_BULK_PARTS_PER_THREAD;
+
+    struct dict_bulk bulk = {
+        .dict = dict,
+        .keys = keys,
+        .values = values,
+        .destructor = destructor,
+        .n = n,
+        .num_threads = num_threads,
+        .num_parts = num_parts < groups ? num_parts : groups,
+        .lens = gdata_alloc(allocator, (n + 1) * sizeof(size_t)),
+        .hashes = gdata_alloc(allocator, (n + 1) * sizeof(uint64_t)),
+        .order = gdata_alloc(allocator, (n + 1) * sizeof(size_t)),
+    };
+    bulk.counts = gdata_calloc(allocator, num_threads * bulk.num_parts, sizeof(size_t));
+    bulk.part_start = gdata_alloc(allocator, (bulk.num_parts + 1) * sizeof(size_t));
+    struct dict_bulk_worker* workers = gdata_calloc(allocator, num_threads, sizeof(*workers));
+    bool failed = !bulk.lens || !bulk.hashes || !bulk.order || !bulk.counts ||
+                  !bulk.part_start || !workers;
+
+    if (!failed) {
+        for (size_t t = 0; t < num_threads; t++)
+            workers[t] = (struct dict_bulk_worker){.bulk = &bulk, .id = t};
+        gdata_run_threads(allocator, workers, sizeof(*workers), num_threads, bulk_hash);
+
+        // counts become the offsets where each thread scatters its keys
+        size_t offset = 0;
+        for (size_t p = 0; p < bulk.num_parts; p++) {
+            bulk.part_start[p] = offset;
+            for (size_t t = 0; t < num_threads; t++) {
+                size_t count = bulk.counts[t * bulk.num_parts + p];
+                bulk.counts[t * bulk.num_parts + p] = offset;
+                offset += count;
+            }
+        }
+        bulk.part_start[bulk.num_parts] = offset;
+        gdata_run_threads(allocator, workers, sizeof(*workers), num_threads, bulk_scatter);
+        gdata_run_threads(allocator, workers, sizeof(*workers), num_threads, bulk_fill);
+    }
+
+    struct dict_table* table = dict->ht;
+    for (size_t t = 0; workers && t < num_threads; t++) {
+        struct dict_bulk_worker* worker = workers + t;
+        if (worker->arena) {
+            struct dict_arena_chunk** tail = &worker->arena;
+            while (*tail) tail = &(*tail)->next;
+            *tail = table->arena;
+            table->arena = worker->arena;
+        }
+        table->size += worker->size;
+        failed = failed || worker->failed;
+    }
+    for (size_t t = 0; !failed && t < num_threads; t++) {
+        for (size_t k = 0; k < workers[t].num_overflow; k++) {
+            size_t i = workers[t].overflow[k];
+            dict_set_hashed(dict, keys[i], bulk.lens[i], bulk.hashes[i], values[i], destructor);
+        }
+    }
 
-    while (a && strncmp(a->key, key, DICT_MAX_KEY_SIZE)) {
-        b = a;
-        a = a->next;
+    for (size_t t = 0; workers && t < num_threads; t++)
+        gdata_free(allocator, workers[t].overflow, workers[t].alloc_overflow * sizeof(size_t));
+    gdata_free(allocator, workers, num_threads * sizeof(*workers));
+    gdata_free(allocator, bulk.lens, (n + 1) * sizeof(size_t));
+    gdata_free(allocator, bulk.hashes, (n + 1) * sizeof(uint64_t));
+    gdata_free(allocator, bulk.order, (n + 1) * sizeof(size_t));
+    gdata_free(allocator, bulk.counts, num_threads * bulk.num_parts * sizeof(size_t));
+    gdata_free(allocator, bulk.part_start, (bulk.num_parts + 1) * sizeof(size_t));
+
+    if (failed) {
+        // values still belong to the caller
+        for (size_t i = 0; i < table->capacity; i++)
+            table->pairs[i].del = NULL;
+        dict_delete(dict);
+        return NULL;
     }
+    return dict;
+}
+
+void dict_remove(Dict dict, const char* key) {
+    if (dict->image)
+        return;
+    dict_rehash(dict, DICT_REHASH_STEP);
+
+    size_t len = strlen(key), slot;
+    uint64_t h = dict_hash(key, len, dict->seed);
+    struct dict_table* table = dict_find(dict, key, len, h, &slot);
+    if (table == NULL)
+        return;
 
-    if (a) {
-        b->next = a->next;
-        if (a->del) a->del(a->value);
-        free(a);
-        dict->num_elements--;
-        dict->update_keys = true;
+    struct dict_pair* pair = table_pair(table, slot);
+    if (pair->del) pair->del(pair->value);
+    if (dict->entries) {
+        pair->len = DICT_ENTRY_REMOVED;
+        dict->entries->deleted++;
     }
+    if (dict->filter)
+        filter_remove(dict->filter, h);
+    table_erase(table, slot);
+    dict->update_keys = true;
+    dict_check_shrink(dict);
 }
 
 void dict_clear(Dict dict) {
-    for (size_t i = 0; i < dict->table_size; i++) {
-        struct dict_pair* curr = dict->table[i], *next;
-        while (curr) {
-            next = curr->next;
-            if (curr->del) curr->del(curr->value);
-            free(curr);
-            curr = next;
+    if (dict->image)
+        return;
+    dict_rehash(dict, SIZE_MAX);
+    dict->version++;
+
+    struct dict_table* table = dict->ht;
+    struct dict_entries* entries = dict->entries;
+    if (entries) {
+        for (size_t i = 0; i < entries->size; i++) {
+            struct dict_pair* pair = entries->at + i;
+            if (pair->len != DICT_ENTRY_REMOVED && pair->del)
+                pair->del(pair->value);
+        }
+        arena_free(dict->allocator, entries->arena);
+        *entries = (struct dict_entries){
+            .at = entries->at,
+            .alloc = entries->alloc,
+            .version = entries->version + 1,
+        };
+    } else {
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->ctrl[i] >= 0 && table->pairs[i].del)
+                table->pairs[i].del(table->pairs[i].value);
         }
     }
-    free(dict->keys);
-    dict->keys == NULL;
+    memset(table->ctrl, CTRL_EMPTY, table->capacity);
+    table->size = 0;
+    table->deleted = 0;
+    arena_free(dict->allocator, table->arena);
+    table->arena = NULL;
+    if (dict->filter)
+        memset(dict->filter->blocks, 0, dict->filter->num_blocks * DICT_FILTER_BLOCK_SIZE);
+
+    gdata_free(dict->allocator, dict->keys, dict->keys_alloc * sizeof(char*));
+    dict->keys = NULL;
+    dict->keys_alloc = 0;
     dict->update_keys = false;
-    dict->num_elements = 0;
 }
 
 const char ** dict_keys(Dict dict) {
+    // keys must not move while the caller reads them with dict_get()
+    dict_rehash(dict, SIZE_MAX);
+
     if (dict->update_keys) {
-        dict->keys = realloc(dict->keys, sizeof(char*)*dict->num_elements);
+        size_t size = dict_size(dict);
+        const char** keys = gdata_realloc(dict->allocator, dict->keys,
+                                          dict->keys_alloc * sizeof(char*), size * sizeof(char*));
+        if (keys == NULL && size)
+            return dict->keys;
+        dict->keys = keys;
+        dict->keys_alloc = size;
 
-        for (size_t i = 0, curr = 0; i < dict->table_size; i++) {
-            struct dict_pair* search_node = dict->table[i];
-            while (search_node) {
-                dict->keys[curr++] = search_node->key;
-                search_node = search_node->next;
-            }
-        }
+        size_t curr = 0;
+        for (DictIter it = dict_iter_begin(dict); dict_iter_next(dict, &it);)
+            dict->keys[curr++] = it.key;
         dict->update_keys = false;
     }
     return dict->keys;
-}
\ No newline at end of file
+}
+
+// ===== ITERATOR ===== //
+
+static uint64_t reverse_bits(uint64_t v) {
+    unsigned s = 64;
+    uint64_t mask = ~0ull;
+    while ((s >>= 1) > 0) {
+        mask ^= mask << s;
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+    return v;
+}
+
+static void iter_restart_bucket(DictIter* it) {
+    it->internal.table = 0;
+    it->internal.expansion = 0;
+    it->internal.step = 0;
+    it->internal.slot = 0;
+}
+
+DictIter dict_iter_begin(Dict dict) {
+    return (DictIter){.internal.version = dict->entries ? dict->entries->version : dict->version};
+}
+
+// Ordered dicts are walked in the entries array, restarting if they move
+static bool entries_iter_next(struct dict_entries* entries, DictIter* it) {
+    if (it->internal.version != entries->version) {
+        it->internal.version = entries->version;
+        it->internal.slot = 0;
+    }
+    while (it->internal.slot < entries->size) {
+        const struct dict_pair* pair = entries->at + it->internal.slot++;
+        if (pair->len == DICT_ENTRY_REMOVED)
+            continue;
+        it->key = pair_key(pair);
+        it->len = pair->len;
+        it->value = pair->value;
+        it->destructor = pair->del;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Like Redis SCAN, the cursor is a home group index incremented on its
+ * reversed bits. Every home group of the smaller table is visited once, with
+ * all the groups it expands to in the bigger one, so growing or shrinking
+ * between calls does not skip any element. The elements of a home group are
+ * found following its probe sequence up to a group with an EMPTY slot.
+ *
+ * ht[0] is visited before ht[1], since rehashing only moves elements from
+ * ht[0] to ht[1] an element can not escape to the part already visited.
+ * When tables are replaced the current home group is visited again.
+ */
+bool dict_iter_next(Dict dict, DictIter* it) {
+    if (it->internal.done)
+        return false;
+    if (dict->image)
+        return image_iter_next(dict->image, it);
+    if (dict->entries)
+        return entries_iter_next(dict->entries, it);
+    if (it->internal.version != dict->version) {
+        it->internal.version = dict->version;
+        iter_restart_bucket(it);
+    }
+
+    size_t small_groups = dict->ht[0].capacity / DICT_GROUP_WIDTH;
+    if (dict_is_rehashing(dict) && dict->ht[1].capacity / DICT_GROUP_WIDTH < small_groups)
+        small_groups = dict->ht[1].capacity / DICT_GROUP_WIDTH;
+    size_t small_mask = small_groups - 1;
+
+    for (;;) {
+        if (it->internal.table > dict_is_rehashing(dict)) {
+            // next home group, in reverse binary order
+            uint64_t cursor = it->internal.cursor | ~(uint64_t)small_mask;
+            cursor = reverse_bits(reverse_bits(cursor) + 1);
+            it->internal.cursor = cursor;
+            iter_restart_bucket(it);
+            if (cursor == 0) {
+                it->internal.done = true;
+                return false;
+            }
+        }
+
+        const struct dict_table* table = dict->ht + it->internal.table;
+        size_t groups = table->capacity / DICT_GROUP_WIDTH;
+        size_t home = (it->internal.cursor & small_mask) + it->internal.expansion * small_groups;
+
+        if (home >= groups || it->internal.step >= groups) {
+            if (home >= groups) {
+                it->internal.table++;
+                it->internal.expansion = 0;
+            } else {
+                it->internal.expansion++;
+            }
+            it->internal.step = 0;
+            it->internal.slot = 0;
+            continue;
+        }
+
+        size_t step = it->internal.step;
+        size_t group = (home + step*(step + 1)/2) & (groups - 1);
+        const int8_t* ctrl = table->ctrl + group * DICT_GROUP_WIDTH;
+
+        while (it->internal.slot < DICT_GROUP_WIDTH) {
+            size_t bit = it->internal.slot++;
+            const struct dict_pair* pair = table->pairs + group * DICT_GROUP_WIDTH + bit;
+            if (ctrl[bit] >= 0 && (hash_h1(pair->hash) & (groups - 1)) == home) {
+                it->key = pair_key(pair);
+                it->len = pair->len;
+                it->value = pair->value;
+                it->destructor = pair->del;
+                return true;
+            }
+        }
+
+        // probing of this home group ends at a group with an EMPTY slot
+        it->internal.slot = 0;
+        if (group_match_empty(ctrl)) {
+            it->internal.step = 0;
+            it->internal.expansion++;
+        } else {
+            it->internal.step++;
+        }
+    }
+}
+
+// ===== FROZEN DICT ===== //
+
+// Average number of keys per bucket
+#define FROZEN_BUCKET_SIZE 4
+
+// Pilots tried for a bucket before starting again with another seed
+#define FROZEN_MAX_PILOT (1u << 16)
+#define FROZEN_MAX_SEEDS 16
+
+// Pilot of buckets placed directly, the low bits are their slot
+#define FROZEN_DIRECT (1u << 31)
+
+/*
+ * Minimal perfect hash (CHD like):
+ * keys are split in buckets by their hash, and each bucket has a pilot
+ * that moves all of its keys to free slots. Buckets are placed from the
+ * biggest to the smallest, the last ones (of a single key) just take
+ * the remaining free slots, which keeps the table minimal.
+ */
+struct frozen_dict {
+    struct dict_pair* pairs;
+    uint32_t* pilots;
+    size_t size;
+    size_t num_buckets;
+    uint64_t seed;
+    struct dict_arena_chunk* arena;
+    const struct gdata_allocator* allocator;
+};
+
+static inline size_t frozen_bucket(const struct frozen_dict* dict, uint64_t h) {
+    return fastrange(h, dict->num_buckets);
+}
+
+// mixed with the pilot, keys of the same bucket get unrelated slots
+static inline size_t frozen_slot(const struct frozen_dict* dict, uint64_t h, uint32_t pilot) {
+    if (pilot & FROZEN_DIRECT)
+        return pilot & ~FROZEN_DIRECT;
+    return fastrange(wymix(h ^ P0, pilot ^ P1), dict->size);
+}
+
+/*
+ * Find a pilot for every bucket with the current seed.
+ * @param slots: receives the slot of each key
+ */
+static bool frozen_place(struct frozen_dict* dict, const uint64_t* hashes, size_t* slots) {
+    size_t n = dict->size, m = dict->num_buckets;
+    const struct gdata_allocator* allocator = dict->allocator;
+    bool result = false;
+
+    // keys grouped by bucket, and buckets sorted by decreasing size
+    size_t* start = gdata_calloc(allocator, m + 2, sizeof(size_t));
+    size_t* keys = gdata_alloc(allocator, (n + 1) * sizeof(size_t));
+    size_t* order = gdata_alloc(allocator, m * sizeof(size_t));
+    bool* taken = gdata_calloc(allocator, n + 1, sizeof(bool));
+    size_t* count = NULL;
+    size_t max_size = 0;
+    if (!start || !keys || !order || !taken)
+        goto end;
+
+    for (size_t i = 0; i < n; i++)
+        start[frozen_bucket(dict, hashes[i]) + 2]++;
+    for (size_t b = 0; b < m; b++)
+        if (start[b + 2] > max_size) max_size = start[b + 2];
+    for (size_t b = 0; b < m; b++)
+        start[b + 2] += start[b + 1];
+    for (size_t i = 0; i < n; i++)
+        keys[start[frozen_bucket(dict, hashes[i]) + 1]++] = i;
+
+    count = gdata_calloc(allocator, max_size + 2, sizeof(size_t));
+    if (count == NULL)
+        goto end;
+    for (size_t b = 0; b < m; b++)
+        count[max_size - (start[b + 1] - start[b]) + 1]++;
+    for (size_t s = 0; s <= max_size; s++)
+        count[s + 1] += count[s];
+    for (size_t b = 0; b < m; b++)
+        order[count[max_size - (start[b + 1] - start[b])]++] = b;
+
+    memset(dict->pilots, 0, m * sizeof(uint32_t));
+    size_t next_free = 0;
+    for (size_t i = 0; i < m; i++) {
+        size_t b = order[i];
+        const size_t* bucket = keys + start[b];
+        size_t bucket_size = start[b + 1] - start[b];
+        if (bucket_size == 0)
+            break;
+
+        if (bucket_size == 1) {
+            while (taken[next_free]) next_free++;
+            dict->pilots[b] = FROZEN_DIRECT | next_free;
+            taken[next_free] = true;
+            slots[bucket[0]] = next_free;
+            continue;
+        }
+
+        uint32_t pilot = 0;
+        for (; pilot < FROZEN_MAX_PILOT; pilot++) {
+            size_t placed = 0;
+            for (; placed < bucket_size; placed++) {
+                size_t slot = frozen_slot(dict, hashes[bucket[placed]], pilot);
+                if (taken[slot])
+                    break;
+                taken[slot] = true;
+                slots[bucket[placed]] = slot;
+            }
+            if (placed == bucket_size)
+                break;
+            while (placed--)
+                taken[slots[bucket[placed]]] = false;
+        }
+        if (pilot == FROZEN_MAX_PILOT)
+            goto end;
+        dict->pilots[b] = pilot;
+    }
+    result = true;
+
+end:
+    gdata_free(allocator, start, (m + 2) * sizeof(size_t));
+    gdata_free(allocator, keys, (n + 1) * sizeof(size_t));
+    gdata_free(allocator, order, m * sizeof(size_t));
+    gdata_free(allocator, taken, (n + 1) * sizeof(bool));
+    gdata_free(allocator, count, (max_size + 2) * sizeof(size_t));
+    return result;
+}
+
+static void frozen_free(FrozenDict dict) {
+    const struct gdata_allocator* allocator = dict->allocator;
+    gdata_free(allocator, dict->pairs, (dict->size + 1) * sizeof(struct dict_pair));
+    gdata_free(allocator, dict->pilots, dict->num_buckets * sizeof(uint32_t));
+    arena_free(allocator, dict->arena);
+    gdata_free(allocator, dict, sizeof(*dict));
+}
+
+FrozenDict dict_freeze(Dict dict) {
+    if (dict->image)
+        return NULL;
+
+    size_t n = dict_size(dict);
+    FrozenDict result = gdata_calloc(dict->allocator, 1, sizeof(*result));
+    struct dict_pair** sources = gdata_alloc(dict->allocator, (n + 1) * sizeof(*sources));
+    uint64_t* hashes = gdata_alloc(dict->allocator, (n + 1) * sizeof(uint64_t));
+    size_t* slots = gdata_alloc(dict->allocator, (n + 1) * sizeof(size_t));
+    bool placed = false;
+    if (!result || !sources || !hashes || !slots)
+        goto end;
+
+    result->allocator = dict->allocator;
+    result->size = n;
+    result->num_buckets = n / FROZEN_BUCKET_SIZE + 1;
+    result->pairs = gdata_alloc(result->allocator, (n + 1) * sizeof(struct dict_pair));
+    result->pilots = gdata_alloc(result->allocator, result->num_buckets * sizeof(uint32_t));
+    if (!result->pairs || !result->pilots)
+        goto end;
+
+    size_t count = 0;
+    for (int t = 0; t < 1 + dict_is_rehashing(dict); t++) {
+        struct dict_table* table = dict->ht + t;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->ctrl[i] < 0) continue;
+            sources[count] = table_pair(table, i);
+            hashes[count] = sources[count]->hash;
+            count++;
+        }
+    }
+
+    // the hashes cached with the dict seed are tried first
+    result->seed = dict->seed;
+    placed = frozen_place(result, hashes, slots);
+    for (unsigned attempt = 1; !placed && attempt < FROZEN_MAX_SEEDS; attempt++) {
+        result->seed = random_seed((uintptr_t)result + attempt);
+        for (size_t i = 0; i < n; i++)
+            hashes[i] = dict_hash(pair_key(sources[i]), sources[i]->len, result->seed);
+        placed = frozen_place(result, hashes, slots);
+    }
+
+    for (size_t i = 0; placed && i < n; i++) {
+        struct dict_pair* pair = result->pairs + slots[i];
+        *pair = *sources[i];
+        pair->hash = hashes[i];
+        if (pair->len >= DICT_INLINE_KEY_SIZE)
+            placed = pair_set_key(result->allocator, pair, &result->arena, sources[i]->key.ptr, pair->len);
+    }
+
+    if (placed) {
+        // values now belong to the frozen dict
+        for (size_t i = 0; i < n; i++)
+            sources[i]->del = NULL;
+        dict_clear(dict);
+    }
+
+end:
+    gdata_free(dict->allocator, sources, (n + 1) * sizeof(*sources));
+    gdata_free(dict->allocator, hashes, (n + 1) * sizeof(uint64_t));
+    gdata_free(dict->allocator, slots, (n + 1) * sizeof(size_t));
+    if (result && !placed) {
+        frozen_free(result);
+        result = NULL;
+    }
+    return result;
+}
+
+void frozen_dict_delete(FrozenDict dict) {
+    for (size_t i = 0; i < dict->size; i++) {
+        if (dict->pairs[i].del)
+            dict->pairs[i].del(dict->pairs[i].value);
+    }
+    frozen_free(dict);
+}
+
+size_t frozen_dict_size(FrozenDict dict) {
+    return dict->size;
+}
+
+void* frozen_dict_get(FrozenDict dict, const char* key) {
+    return frozen_dict_get_len(dict, key, strlen(key));
+}
+
+void* frozen_dict_get_len(FrozenDict dict, const char* key, size_t len) {
+    if (dict->size == 0)
+        return NULL;
+    uint64_t h = dict_hash(key, len, dict->seed);
+    uint32_t pilot = dict->pilots[frozen_bucket(dict, h)];
+    const struct dict_pair* pair = dict->pairs + frozen_slot(dict, h, pilot);
+    return pair_key_equals(pair, key, len, h) ? pair->value : NULL;
+}
+
+// ===== TYPED DICT ===== //
+
+DICT_TYPEDEF(uint8_t, uint8_t);
+typedef uint8_t_uint8_tDict TypedDict;
+
+#define TDICT_ENTRY(dict, slot) ((uint8_t*)(dict)->at + (slot)*(dict)->internal.esize)
+#define TDICT_VALUE(dict, entry) ((entry) + (dict)->internal.voffset)
+
+static bool tdict_alloc(TypedDict dict, size_t capacity) {
+    size_t esize = dict->internal.esize;
+    void* block = gdata_alloc(dict->internal.allocator, capacity * (esize + 1));
+    if (block == NULL)
+        return false;
+    dict->at = block;
+    dict->internal.ctrl = (int8_t*)block + capacity*esize;
+    dict->internal.capacity = capacity;
+    dict->internal.deleted = 0;
+    memset(dict->internal.ctrl, CTRL_EMPTY, capacity);
+    return true;
+}
+
+static size_t tdict_find(TypedDict dict, const void* key, uint64_t h) {
+    size_t ksize = dict->internal.ksize;
+    int8_t h2 = hash_h2(h);
+    PROBE_FOR(group, dict->internal.capacity, h) {
+        const int8_t* ctrl = dict->internal.ctrl + group * DICT_GROUP_WIDTH;
+        MASK_FOR(bit, group_match(ctrl, h2)) {
+            size_t slot = group * DICT_GROUP_WIDTH + bit;
+            if (memcmp(TDICT_ENTRY(dict, slot), key, ksize) == 0)
+                return slot;
+        }
+        if (group_match_empty(ctrl))
+            break;
+    }
+    return dict->internal.capacity;
+}
+
+static size_t tdict_insert_slot(TypedDict dict, uint64_t h) {
+    PROBE_FOR(group, dict->internal.capacity, h) {
+        uint32_t mask = group_match_free(dict->internal.ctrl + group * DICT_GROUP_WIDTH);
+        if (mask) {
+            size_t slot = group * DICT_GROUP_WIDTH + __builtin_ctz(mask);
+            if (dict->internal.ctrl[slot] == CTRL_DELETED)
+                dict->internal.deleted--;
+            dict->internal.ctrl[slot] = hash_h2(h);
+            return slot;
+        }
+    }
+    return dict->internal.capacity;
+}
+
+static bool tdict_resize(TypedDict dict, size_t capacity) {
+    uint8_t* old_entries = (uint8_t*)dict->at;
+    int8_t* old_ctrl = dict->internal.ctrl;
+    size_t old_capacity = dict->internal.capacity;
+    size_t esize = dict->internal.esize;
+
+    if (!tdict_alloc(dict, capacity))
+        return false;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] < 0) continue;
+        uint8_t* entry = old_entries + i*esize;
+        uint64_t h = dict_hash(entry, dict->internal.ksize, dict->internal.seed);
+        memcpy(TDICT_ENTRY(dict, tdict_insert_slot(dict, h)), entry, esize);
+    }
+    gdata_free(dict->internal.allocator, old_entries, old_capacity * (esize + 1));
+    return true;
+}
+
+void* tdict_create(size_t ksize, size_t vsize, size_t voffset, size_t esize, size_t size) {
+    return tdict_create_with(gdata_default_allocator(), ksize, vsize, voffset, esize, size);
+}
+
+void* tdict_create_with(const struct gdata_allocator* allocator, size_t ksize, size_t vsize,
+                        size_t voffset, size_t esize, size_t size) {
+    TypedDict dict = gdata_alloc(allocator, sizeof(*dict));
+    if (dict) {
+        *dict = (struct uint8_t_uint8_t_dict){
+            .internal.seed = random_seed((uintptr_t)dict),
+            .internal.ksize = ksize,
+            .internal.vsize = vsize,
+            .internal.voffset = voffset,
+            .internal.esize = esize,
+            .internal.allocator = allocator,
+        };
+        if (!tdict_alloc(dict, capacity_for_load(size, DICT_DEFAULT_GROW))) {
+            gdata_free(allocator, dict, sizeof(*dict));
+            return NULL;
+        }
+    }
+    return dict;
+}
+
+void tdict_delete(void* dict) {
+    TypedDict D = dict;
+    gdata_free(D->internal.allocator, D->at, D->internal.capacity * (D->internal.esize + 1));
+    gdata_free(D->internal.allocator, D, sizeof(*D));
+}
+
+void* tdict_set(void* dict, const void* key, const void* value) {
+    TypedDict D = dict;
+    uint64_t h = dict_hash(key, D->internal.ksize, D->internal.seed);
+    size_t slot = tdict_find(D, key, h);
+
+    if (slot == D->internal.capacity) {
+        size_t capacity = D->internal.capacity;
+        if (D->size + D->internal.deleted >= (size_t)(capacity * DICT_DEFAULT_GROW)) {
+            // too many tombstones are cleaned up without growing
+            capacity = capacity_for_load(2*(D->size + 1), DICT_DEFAULT_GROW);
+            if (!tdict_resize(D, capacity))
+                return NULL;
+        }
+        slot = tdict_insert_slot(D, h);
+        memcpy(TDICT_ENTRY(D, slot), key, D->internal.ksize);
+        D->size++;
+    }
+
+    uint8_t* entry = TDICT_ENTRY(D, slot);
+    if (value)
+        memcpy(TDICT_VALUE(D, entry), value, D->internal.vsize);
+    return TDICT_VALUE(D, entry);
+}
+
+void* tdict_get(const void* dict, const void* key) {
+    TypedDict D = (TypedDict)dict;
+    size_t slot = tdict_find(D, key, dict_hash(key, D->internal.ksize, D->internal.seed));
+    if (slot == D->internal.capacity)
+        return NULL;
+    return TDICT_VALUE(D, TDICT_ENTRY(D, slot));
+}
+
+bool tdict_remove(void* dict, const void* key) {
+    TypedDict D = dict;
+    size_t slot = tdict_find(D, key, dict_hash(key, D->internal.ksize, D->internal.seed));
+    if (slot == D->internal.capacity)
+        return false;
+
+    const int8_t* group = D->internal.ctrl + slot / DICT_GROUP_WIDTH * DICT_GROUP_WIDTH;
+    if (group_match_empty(group)) {
+        D->internal.ctrl[slot] = CTRL_EMPTY;
+    } else {
+        D->internal.ctrl[slot] = CTRL_DELETED;
+        D->internal.deleted++;
+    }
+    D->size--;
+    return true;
+}
+
+void tdict_clear(void* dict) {
+    TypedDict D = dict;
+    memset(D->internal.ctrl, CTRL_EMPTY, D->internal.capacity);
+    D->internal.deleted = 0;
+    D->size = 0;
+}
+
+void* tdict_next(const void* dict, const void* entry) {
+    TypedDict D = (TypedDict)dict;
+    size_t slot = entry ? ((uint8_t*)entry - (uint8_t*)D->at) / D->internal.esize + 1 : 0;
+    for (; slot < D->internal.capacity; slot++) {
+        if (D->internal.ctrl[slot] >= 0)
+            return TDICT_ENTRY(D, slot);
+    }
+    return NULL;
+}
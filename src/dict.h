@@ -2,18 +2,63 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include "allocator.h"
 
 typedef struct dict* Dict;
 
 /**
- * @brief Allocate a new dictionary (hash map)
+ * @brief Cursor over the elements of a Dict, see dict_iter_next()
  * 
- * @param table_size: size of the hash-table
+ * key, value and destructor refer to the current element
+ */
+typedef struct dict_iter {
+    const char* key;
+    size_t len;
+    void* value;
+    void(*destructor)(void*);
+    struct {
+        uint64_t cursor;
+        uint64_t version;
+        size_t table;
+        size_t expansion;
+        size_t step;
+        size_t slot;
+        bool done;
+    } internal;
+} DictIter;
+
+/**
+ * @brief Allocate a new dictionary (open addressing hash map)
+ * The table grows and shrinks by itself, see dict_set_load_factor()
+ * 
+ * @param table_size: number of elements expected, the table is
+ * sized to hold them without growing
  * @return A new allocated Dictionary
  */
 Dict dict_create(size_t table_size);
 
+/**
+ * @brief Like dict_create(), the dictionary, its tables and keys are allocated
+ * by `allocator`. Dicts made from it with dict_freeze() use it too,
+ * and so do the buffers of dict_save() and dict_freeze()
+ */
+Dict dict_create_with(const struct gdata_allocator* allocator, size_t table_size);
+
+/**
+ * @brief Allocate a new dictionary that remembers insertion order.
+ * Elements are appended to a dense array indexed by the hash table, so
+ * iteration and dict_keys() follow insertion order and only walk elements.
+ * Updating a key keeps its position.
+ * 
+ * @param table_size: number of elements expected
+ */
+Dict dict_create_ordered(size_t table_size);
+
+/// @brief Like dict_create_ordered(), allocating with `allocator`. see dict_create_with()
+Dict dict_create_ordered_with(const struct gdata_allocator* allocator, size_t table_size);
+
 
 /**
  * @brief Free a dictionary and all it's contents
@@ -28,6 +73,23 @@ void dict_delete(Dict dict);
  */
 size_t dict_size(Dict dict);
 
+/**
+ * @brief Get number of slots allocated.
+ * While resizing, both the old and the new table are counted
+ */
+size_t dict_capacity(Dict dict);
+
+/**
+ * @brief Configure when the table is resized.
+ * Resizing is incremental: elements are moved to the new table
+ * a few at a time by the following dict_set(), dict_get() and dict_remove().
+ * 
+ * @param grow: grows when this fraction of the slots is used (default 0.875)
+ * @param shrink: shrinks when less than this fraction of the slots is used.
+ * (default 0, never shrinks). Limited to grow/4 to avoid resizing back and forth
+ */
+void dict_set_load_factor(Dict dict, float grow, float shrink);
+
 
 /**
  * @brief Add a new key-value or update a existing one.
@@ -67,6 +129,52 @@ void dict_setref(Dict dict, const char* key, void* value);
  */
 void* dict_get(Dict dict, const char* key);
 
+/**
+ * @brief Same as dict_get() for a key of known length.
+ * The key does not need to be NUL terminated
+ */
+void* dict_get_len(Dict dict, const char* key, size_t len);
+
+/**
+ * @brief dict_get() for `n` keys at once.
+ * Keys are hashed and their slots prefetched in batches,
+ * so the cache misses of many lookups overlap.
+ * 
+ * @param values: receives the `n` values (NULL for keys not defined)
+ */
+void dict_get_many(Dict dict, const char** keys, size_t n, void** values);
+
+/**
+ * @brief dict_set() for `n` keys at once, see dict_get_many()
+ * 
+ * @param destructor: used for all values
+ */
+void dict_set_many(Dict dict, const char** keys, void** values, size_t n,
+                   void(*destructor)(void*));
+
+/**
+ * @brief Create a dictionary with `n` keys using many threads.
+ * Keys are hashed and partitioned by their place in the table in parallel,
+ * then each thread fills its own part of the table without locking.
+ * Repeated keys keep the last value, like dict_set()
+ * 
+ * @param num_threads: 0 uses one thread per processor. Limited so that
+ * each thread gets a few thousand keys, and to 256
+ * @param destructor: used for all values
+ * @return NULL if out of memory (no destructor is called)
+ */
+Dict dict_build_bulk(const char** keys, void** values, size_t n, size_t num_threads,
+                     void(*destructor)(void*));
+
+/**
+ * @brief Like dict_build_bulk(), the dictionary and the buffers used to
+ * build it are allocated by `allocator`. see dict_create_with()
+ * @note the building threads call the allocator at the same time,
+ * it must be thread safe
+ */
+Dict dict_build_bulk_with(const struct gdata_allocator* allocator, const char** keys,
+                          void** values, size_t n, size_t num_threads, void(*destructor)(void*));
+
 /**
  * @brief Remove a key from the dictionary.
  * 
@@ -79,8 +187,255 @@ void dict_remove(Dict dict, const char* key);
  */
 void dict_clear(Dict dict);
 
+/**
+ * @brief Start iterating over a dictionary, no memory is allocated.
+ * 
+ * usage:
+ *      for (DictIter it = dict_iter_begin(dict); dict_iter_next(dict, &it);)
+ *          printf("%s: %p\n", it.key, it.value);
+ */
+DictIter dict_iter_begin(Dict dict);
+
+/**
+ * @brief Move to the next element
+ * 
+ * The dictionary can be modified during the iteration (like Redis SCAN):
+ * elements present during the whole iteration are visited at least once,
+ * but may be visited twice if the table is resized in between
+ * 
+ * @return false when there are no more elements
+ * @note it.key is valid until the next call on the dictionary
+ */
+bool dict_iter_next(Dict dict, DictIter* iter);
+
 /**
  * @brief Get a list of string keys.
  * The number of elements is obtainable by dict_size()
+ * 
+ * @note keys are valid until the next dict_set(), dict_remove() or dict_clear()
  */
 const char ** dict_keys(Dict dict);
+
+/**
+ * @brief Statistics of the filter enabled with dict_enable_filter()
+ */
+typedef struct dict_filter_stats {
+    size_t lookups;             // lookups that checked the filter
+    size_t negatives;           // misses answered by the filter alone
+    size_t false_positives;     // misses the filter let through to the table
+    double false_positive_rate; // false_positives / all misses
+    size_t memory;              // bytes used by the filter
+} DictFilterStats;
+
+/**
+ * @brief Keep a counting Bloom filter of the keys in front of the table.
+ * dict_get() and dict_get_many() answer most misses from one cache line
+ * of the filter. It's updated by every set and remove, and rebuilt
+ * bigger when the dict grows past twice the size it was built for.
+ * 
+ * @param expected_size: number of elements the filter is sized for
+ * @return false if out of memory or the dict is mapped
+ */
+bool dict_enable_filter(Dict dict, size_t expected_size);
+
+/// @brief Get statistics of the filter (all zero if not enabled)
+DictFilterStats dict_filter_stats(Dict dict);
+
+/**
+ * @brief Write a snapshot of the dictionary to a file, see dict_open_mmap()
+ * The file is written aside and renamed, processes using the old one are not affected
+ * 
+ * @param value_size: number of bytes of each value to save, values are copied
+ * as NUL terminated strings if NULL
+ * @return false if the file could not be written
+ */
+bool dict_save(Dict dict, const char* path, size_t (*value_size)(const void* value));
+
+/**
+ * @brief Map a file written by dict_save() as a read-only dictionary.
+ * Nothing is loaded: dict_get() reads the hash index and values straight from
+ * the mapped file, whose pages are shared by every process mapping it.
+ * 
+ * The index is checked once at open, reading every key's terminator.
+ * 
+ * @return NULL if the file can not be mapped, was not written by dict_save()
+ * on a machine of the same kind, or is truncated or corrupted
+ * @note dict_set(), dict_remove() and dict_clear() do nothing on it,
+ * values must not be modified. dict_delete() unmaps the file
+ */
+Dict dict_open_mmap(const char* path);
+
+/**
+ * @brief Hash `len` bytes of data (wyhash).
+ * Each Dict uses it with its own random seed
+ */
+uint64_t dict_hash(const void* data, size_t len, uint64_t seed);
+
+
+// ===== FROZEN DICT ===== //
+
+/**
+ * Immutable dictionary built once from a Dict.
+ * Keys are placed with a minimal perfect hash: each key has a slot of its
+ * own and there are no empty slots, so a lookup is one hash, one probe and
+ * one key compare.
+ */
+typedef struct frozen_dict* FrozenDict;
+
+/**
+ * @brief Build a frozen dictionary with the contents of `dict`.
+ * Values and their destructors are moved to it: `dict` is left empty
+ * and must still be deleted with dict_delete()
+ * 
+ * @return NULL if out of memory or `dict` is mapped (`dict` is not changed)
+ */
+FrozenDict dict_freeze(Dict dict);
+
+/**
+ * @brief Free a frozen dictionary and all it's contents
+ * all detructor functions defined will be called
+ */
+void frozen_dict_delete(FrozenDict dict);
+
+/// @brief Get number of elements
+size_t frozen_dict_size(FrozenDict dict);
+
+/**
+ * @brief Get pointer to the value of key.
+ * @return pointer or NULL if not defined.
+ */
+void* frozen_dict_get(FrozenDict dict, const char* key);
+
+/// @brief Same as frozen_dict_get() for a key of known length
+void* frozen_dict_get_len(FrozenDict dict, const char* key, size_t len);
+
+
+// ===== TYPED DICT ===== //
+
+/**
+ * @brief Declare a hash map with fixed size keys and use `keytype_valuetypeDict`
+ * Keys and values are stored inline in one flat table (no allocation per entry)
+ * @usage:
+ *      DICT_TYPEDEF(int, float);
+ *      and int_floatDict is now available
+ * 
+ * @note: keys are hashed and compared byte by byte, keys with padding
+ *        bytes (some structs) must have them zeroed
+ * 
+ * @note: like VECTOR_TYPEDEF, types must be a single name
+ */
+#define DICT_TYPEDEF(ktype, vtype)\
+struct ktype##_##vtype##_dict_entry {\
+    ktype key;\
+    vtype value;\
+};\
+typedef struct ktype##_##vtype##_dict {\
+    size_t size;\
+    struct ktype##_##vtype##_dict_entry *at;\
+    struct {\
+        int8_t *ctrl;\
+        size_t capacity;\
+        size_t deleted;\
+        uint64_t seed;\
+        size_t ksize;\
+        size_t vsize;\
+        size_t voffset;\
+        size_t esize;\
+        const struct gdata_allocator* allocator;\
+    } internal;\
+} *ktype##_##vtype##Dict
+
+// Declaring basic typed dicts
+DICT_TYPEDEF(int, int);
+DICT_TYPEDEF(int, float);
+
+/**
+ * @brief Creates a new typed dict
+ * @note: You must call `tdict_delete()` later
+ * 
+ * @param ktype, vtype: types used in DICT_TYPEDEF()
+ */
+#define TDICT_CREATE(ktype, vtype)\
+    (ktype##_##vtype##Dict)tdict_create(sizeof(ktype), sizeof(vtype),\
+        offsetof(struct ktype##_##vtype##_dict_entry, value),\
+        sizeof(struct ktype##_##vtype##_dict_entry), 0)
+
+/**
+ * @brief Add a new key-value or update a existing one
+ * @param key, value: passed by value
+ */
+#define TDICT_SET(dict, k, v) ({\
+    typeof((dict)->at->key) _key = (k);\
+    typeof((dict)->at->value) _value = (v);\
+    tdict_set(dict, &_key, &_value);\
+})
+
+/**
+ * @brief Get pointer to the value of key, NULL if not defined
+ * @param key: passed by value
+ */
+#define TDICT_GET(dict, k) ({\
+    typeof((dict)->at->key) _key = (k);\
+    (typeof(&(dict)->at->value))tdict_get(dict, &_key);\
+})
+
+/**
+ * @brief Remove a key, returns false if not defined
+ * @param key: passed by value
+ */
+#define TDICT_REMOVE(dict, k) ({\
+    typeof((dict)->at->key) _key = (k);\
+    tdict_remove(dict, &_key);\
+})
+
+/**
+ * @brief For each entry of a typed dict (entry->key, entry->value)
+ * @note: adding or removing keys inside the loop is not supported
+ */
+#define TDICT_FOR_EACH(entry, dict)\
+    for (typeof((dict)->at) entry = tdict_next(dict, NULL);\
+        entry != NULL;\
+        entry = tdict_next(dict, entry))
+
+/**
+ * @brief Create a typed dict
+ * see TDICT_CREATE() macro
+ * 
+ * @param ksize: size of the key in bytes
+ * @param vsize: size of the value in bytes
+ * @param voffset: offset of the value in each entry
+ * @param esize: size of each entry (key, value and padding)
+ * @param size: number of elements expected
+ */
+void* tdict_create(size_t ksize, size_t vsize, size_t voffset, size_t esize, size_t size);
+
+/// @brief Like tdict_create(), the table is allocated by `allocator`
+void* tdict_create_with(const struct gdata_allocator* allocator, size_t ksize, size_t vsize,
+                        size_t voffset, size_t esize, size_t size);
+
+/// @brief Free a typed dict
+void tdict_delete(void* dict);
+
+/**
+ * @brief Add a new key-value or update a existing one.
+ * 
+ * @param key: reference to key (copied)
+ * @param value: reference to value (copied), if NULL a new value is left uninitialized
+ * @return reference to the stored value, valid until the next insertion
+ */
+void* tdict_set(void* dict, const void* key, const void* value);
+
+/// @brief Get reference to the value of key, NULL if not defined
+void* tdict_get(const void* dict, const void* key);
+
+/// @brief Remove a key, returns false if not defined
+bool tdict_remove(void* dict, const void* key);
+
+/// @brief Remove all keys
+void tdict_clear(void* dict);
+
+/**
+ * @brief Get the next entry after `entry` (first if NULL)
+ * @return NULL at the end
+ */
+void* tdict_next(const void* dict, const void* entry);
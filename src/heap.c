@@ -58,15 +58,28 @@ static void heap_downheapify(Heap heap) {
 
 void* heap_create(size_t dsize, size_t max_size, comparator cmp, 
                   enum HeapOrder order) {
-    Heap heap = calloc(1, sizeof(struct heap) + dsize*(max_size+1));
+    return heap_create_with(gdata_default_allocator(), dsize, max_size, cmp, order);
+}
+
+void* heap_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                       size_t max_size, comparator cmp, enum HeapOrder order) {
+    Heap heap = gdata_calloc(allocator, 1, sizeof(struct heap) + dsize*(max_size+1));
+    if (heap == NULL)
+        return NULL;
     heap->size = 0;
     *(enum HeapOrder*)&heap->order = order;
     *(comparator*)&heap->internal.cmp = cmp;
     *(size_t*)&heap->internal.dsize = dsize;
     *(size_t*)&heap->internal.alloc = max_size;
+    *(const struct gdata_allocator**)&heap->internal.allocator = allocator;
     return heap;
 }
 
+void heap_delete(void* heap) {
+    Heap H = heap;
+    gdata_free(H->internal.allocator, H, sizeof(struct heap) + H->internal.dsize*(H->internal.alloc+1));
+}
+
 void heap_push(void *heap, void *data) {
     Heap H = heap;
     H->size++;
@@ -93,12 +106,16 @@ void* heap_root(void* heap) {
     return ((Heap)heap)->at + ((Heap)heap)->internal.dsize;
 }
 
+// a - b overflows for ints and truncates differences below 1 for floats
 int intcmp(void* a, void* b) {
-    return *(int*)a - *(int*)b;
+    int x = *(int*)a, y = *(int*)b;
+    return (x > y) - (x < y);
 }
 int floatcmp(void* a, void* b) {
-    return *(float*)a - *(float*)b;
+    float x = *(float*)a, y = *(float*)b;
+    return (x > y) - (x < y);
 }
 int doublecmp(void* a, void* b) {
-    return *(double*)a - *(double*)b;
+    double x = *(double*)a, y = *(double*)b;
+    return (x > y) - (x < y);
 }
\ No newline at end of file
@@ -14,18 +14,56 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include "allocator.h"
 
+/**
+ * @brief Define a new type of Heap
+ * 
+ * Also declares the specialized `type_heap_push()`, `type_heap_pop()`
+ * and `type_heap_root()`, passing values by value
+ */
 #define HEAP_TYPEDEF(type)\
-typedef struct type##_heap {\
+struct type##_heap {\
     size_t size;\
     const enum HeapOrder order;\
     struct {\
         size_t alloc;\
         const comparator cmp;\
         const size_t dsize;\
+        const struct gdata_allocator* allocator;\
     } internal;\
     type at[];\
-} *type##Heap
+};\
+/* true if `a` goes closer to the root than `b` */\
+static inline bool type##_heap_before(const struct type##_heap* h, type* a, type* b) {\
+    int cmp = h->internal.cmp(a, b);\
+    return h->order == MIN_HEAP ? cmp < 0 : cmp > 0;\
+}\
+static inline void type##_heap_push(struct type##_heap* h, type value) {\
+    size_t k = ++h->size;\
+    for (; k >= 2 && type##_heap_before(h, &value, h->at + k/2); k /= 2)\
+        h->at[k] = h->at[k/2];\
+    h->at[k] = value;\
+}\
+static inline type type##_heap_pop(struct type##_heap* h) {\
+    type root = h->at[1], last = h->at[h->size--];\
+    size_t p = 1, f = 2;\
+    for (; f <= h->size; p = f, f = 2*p) {\
+        if (f < h->size && type##_heap_before(h, h->at + f + 1, h->at + f))\
+            f++;\
+        if (!type##_heap_before(h, h->at + f, &last))\
+            break;\
+        h->at[p] = h->at[f];\
+    }\
+    h->at[p] = last;\
+    h->at[0] = root;\
+    return root;\
+}\
+static inline type type##_heap_root(const struct type##_heap* h) {\
+    return h->at[1];\
+}\
+typedef struct type##_heap *type##Heap
 
 enum HeapOrder {
     MIN_HEAP,
@@ -52,6 +90,7 @@ typedef struct heap {
         size_t alloc;
         comparator cmp;
         size_t dsize;
+        const struct gdata_allocator* allocator;
     } internal;
     uint8_t at[];
 } *Heap;
@@ -67,6 +106,18 @@ typedef struct heap {
  */ 
 void* heap_create(size_t dsize, size_t max_size, comparator cmp, enum HeapOrder order);
 
+/**
+ * @brief Like heap_create(), the heap is allocated by `allocator`
+ */
+void* heap_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                       size_t max_size, comparator cmp, enum HeapOrder order);
+
+/**
+ * @brief Destructor.
+ * `free(heap)` is enough for heaps of gdata_libc_allocator
+ */
+void heap_delete(void* heap);
+
 /**
  * @brief Push a new item maintaining heap structure
  * 
@@ -2,12 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* 
+ * Bytes of each node, the same as sizeof() of the nodes of LIST_TYPEDEF
+ * lists, so both kinds of functions can free them
+ */
+static size_t _list_node_size(const List* list) {
+    size_t size = sizeof(struct list_node) + list->internal.dsize;
+    return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
 /* 
  * Allocate a list_node and return the pointer
- * obs: size in bytes
  */
-static struct list_node *_list_new_node(size_t size) {
-    return calloc(1,sizeof(struct list_node) + size);
+static struct list_node *_list_new_node(List* list) {
+    return gdata_calloc(list->internal.allocator, 1, _list_node_size(list));
 }
 
 /* 
@@ -40,7 +48,15 @@ void * list_at(void* list, int index) {
 
 // ### Constructor
 void* list_create(size_t dsize, size_t initial_size, void * initial_values) {
-    List* list = calloc(1,sizeof(*list));
+    return list_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* list_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                       size_t initial_size, void * initial_values) {
+    List* list = gdata_calloc(allocator, 1, sizeof(*list));
+    if (list == NULL)
+        return NULL;
+    list->internal.allocator = allocator;
     *(size_t*)&list->internal.dsize = dsize;
     if (initial_values)
         list_pushback(list, initial_size, initial_values);
@@ -53,7 +69,7 @@ void* list_create(size_t dsize, size_t initial_size, void * initial_values) {
 void list_pushback(void* list, size_t num_elements, void *data) {
     List* L = list;
     while (num_elements--) {
-        struct list_node *new_node = _list_new_node(L->internal.dsize);
+        struct list_node *new_node = _list_new_node(L);
 
         if (data) {
             memcpy(new_node->data, data, L->internal.dsize);
@@ -73,7 +89,7 @@ void list_pushback(void* list, size_t num_elements, void *data) {
 void list_pushfront(void* list, size_t num_elements, void * data) {
     List* L = list;
     while (num_elements--) {
-        struct list_node *new_node = _list_new_node(L->internal.dsize);
+        struct list_node *new_node = _list_new_node(L);
 
         if (data) {
             void* curr = (char*)data + num_elements*L->internal.dsize;
@@ -95,7 +111,7 @@ void list_push(void* list, int index, void * item) {
     struct list_node *old_node = _list_node_at(list, index);
     if (old_node == NULL) return;
 
-    struct list_node *new_node = _list_new_node(L->internal.dsize);
+    struct list_node *new_node = _list_new_node(L);
     if (new_node == NULL) return;
 
     // Goes before old item
@@ -134,7 +150,7 @@ void *list_pop_node(void* list, void* _node) {
     L->size--;
 
     if (L->internal.pop)
-        free(L->internal.pop);
+        gdata_free(L->internal.allocator, L->internal.pop, _list_node_size(L));
 
     if (node->back) node->back->next = node->next;
     if (node->next) node->next->back = node->back;
@@ -162,7 +178,7 @@ void list_resize(void* list, unsigned int new_size) {
 
 void* list_copy(void* list) {
     List *L = list;
-    List *result = list_create(L->internal.dsize, 0, 0);
+    List *result = list_create_with(L->internal.allocator, L->internal.dsize, 0, 0);
     struct list_node* node = L->head;
     while (node) {
         list_pushback(result, 1, node->data);
@@ -176,11 +192,11 @@ void list_clear(void* list) {
     struct list_node *node = L->head, *next;
     while (node) {
         next = node->next;
-        free(node);
+        gdata_free(L->internal.allocator, node, _list_node_size(L));
         node = next;
     }
     if (L->internal.pop)
-        free(L->internal.pop);
+        gdata_free(L->internal.allocator, L->internal.pop, _list_node_size(L));
     L->internal.pop = L->head = L->tail = NULL;
     L->size = 0;
 }
@@ -198,12 +214,12 @@ void list_to_array(void* list, void* result) {
 
 void list_delete(void* list) {
     list_clear(list);
-    free(list);
+    gdata_free(((List*)list)->internal.allocator, list, sizeof(List));
 }
 
 void* list_slice(void* list, unsigned int begin, unsigned int end) {
     List* L = list;
-    List* result = list_create(L->internal.dsize, 0, 0);
+    List* result = list_create_with(L->internal.allocator, L->internal.dsize, 0, 0);
     struct list_node* node = L->head;
 
     end -= begin;
@@ -12,12 +12,18 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdbool.h>
+#include "allocator.h"
 
 // ===== MACROS ===== //
 
 /**
  * @brief Define a new type of List
+ * 
+ * Also declares the specialized `type_list_pushback()`, `type_list_pushfront()`,
+ * `type_list_popback()`, `type_list_popfront()` and `type_list_at()`,
+ * passing values by value
  */
 #define LIST_TYPEDEF(type)\
 struct type##_list_node {\
@@ -25,15 +31,59 @@ struct type##_list_node {\
     struct type##_list_node* back;\
     type data;\
 };\
-typedef struct type ## _list {\
+struct type ## _list {\
     size_t size;\
     struct type##_list_node* head;\
     struct type##_list_node* tail;\
     struct {\
         struct type##_list_node* pop;\
         const size_t dsize;\
+        const struct gdata_allocator* allocator;\
     } internal;\
-} *type ## List
+};\
+static inline void type ## _list_pushback(struct type ## _list* l, type value) {\
+    struct type##_list_node* node = gdata_alloc(l->internal.allocator, sizeof(*node));\
+    if (node == NULL) return;\
+    *node = (struct type##_list_node){.back = l->tail, .data = value};\
+    if (l->size++ > 0) l->tail->next = node;\
+    else l->head = node;\
+    l->tail = node;\
+}\
+static inline void type ## _list_pushfront(struct type ## _list* l, type value) {\
+    struct type##_list_node* node = gdata_alloc(l->internal.allocator, sizeof(*node));\
+    if (node == NULL) return;\
+    *node = (struct type##_list_node){.next = l->head, .data = value};\
+    if (l->size++ > 0) l->head->back = node;\
+    else l->tail = node;\
+    l->head = node;\
+}\
+static inline type type ## _list_popback(struct type ## _list* l) {\
+    struct type##_list_node* node = l->tail;\
+    type value = node->data;\
+    l->tail = node->back;\
+    if (--l->size) l->tail->next = NULL;\
+    else l->head = NULL;\
+    gdata_free(l->internal.allocator, node, sizeof(*node));\
+    return value;\
+}\
+static inline type type ## _list_popfront(struct type ## _list* l) {\
+    struct type##_list_node* node = l->head;\
+    type value = node->data;\
+    l->head = node->next;\
+    if (--l->size) l->head->back = NULL;\
+    else l->tail = NULL;\
+    gdata_free(l->internal.allocator, node, sizeof(*node));\
+    return value;\
+}\
+static inline type* type ## _list_at(struct type ## _list* l, int index) {\
+    struct type##_list_node* node;\
+    if (index < 0)\
+        for (node = l->tail; ++index; node = node->back);\
+    else\
+        for (node = l->head; index--; node = node->next);\
+    return &node->data;\
+}\
+typedef struct type ## _list *type ## List
 
 // get list's type witch is holded by internal.dtype
 #define LIST_DTYPE(list) typeof((list)->head->data)
@@ -145,6 +195,7 @@ typedef struct list {
     struct {
         struct list_node* pop;
         const size_t dsize;
+        const struct gdata_allocator* allocator;
     } internal;
 } List;
 
@@ -160,6 +211,13 @@ typedef struct list {
  */
 void* list_create(size_t dsize, size_t initial_size, void *initial_values);
 
+/**
+ * @brief Like list_create(), the list and its nodes are allocated by `allocator`.
+ * Copies and slices use it too
+ */
+void* list_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                       size_t initial_size, void *initial_values);
+
 /**
  * @brief Push `num_elements` in `data` to list's end.
  * 
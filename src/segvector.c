@@ -0,0 +1,137 @@
+#include "segvector.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+SEGVECTOR_TYPEDEF(uint8_t);
+
+#define FIRST_BLOCK ((size_t)1 << SEGVECTOR_FIRST_BITS)
+
+/*
+ * Block k holds FIRST_BLOCK << k elements and starts at index
+ * FIRST_BLOCK * (2^k - 1), so `index + FIRST_BLOCK` has its highest bit
+ * at k + SEGVECTOR_FIRST_BITS and the bits below it are the offset
+ */
+static inline size_t block_of(size_t index, size_t* offset) {
+    size_t i = index + FIRST_BLOCK;
+    size_t high = 63 - __builtin_clzll(i);
+    *offset = i ^ ((size_t)1 << high);
+    return high - SEGVECTOR_FIRST_BITS;
+}
+
+static inline size_t block_length(size_t k) {
+    return FIRST_BLOCK << k;
+}
+
+// Number of elements held by the first `num_blocks` blocks
+static inline size_t capacity_of(size_t num_blocks) {
+    return FIRST_BLOCK * (((size_t)1 << num_blocks) - 1);
+}
+
+static bool grow(uint8_tSegVector v, size_t capacity) {
+    size_t dsize = v->internal.dsize;
+    while (capacity_of(v->internal.num_blocks) < capacity) {
+        size_t k = v->internal.num_blocks;
+        if (k == SEGVECTOR_MAX_BLOCKS)
+            return false;
+        uint8_t* block = gdata_alloc(v->internal.allocator, block_length(k) * dsize);
+        if (block == NULL)
+            return false;
+        v->internal.blocks[k] = block;
+        v->internal.num_blocks++;
+    }
+    return true;
+}
+
+/*
+ * Copy `n` elements between `data` and the vector starting at `index`,
+ * one block at a time
+ */
+static void copy_range(uint8_tSegVector v, size_t index, uint8_t* data, size_t n, bool in) {
+    size_t dsize = v->internal.dsize;
+    size_t offset;
+    size_t k = block_of(index, &offset);
+    while (n) {
+        size_t count = block_length(k) - offset;
+        if (count > n)
+            count = n;
+        uint8_t* slot = v->internal.blocks[k] + offset*dsize;
+        if (data == NULL)
+            memset(slot, 0, count*dsize);
+        else if (in)
+            memcpy(slot, data, count*dsize);
+        else
+            memcpy(data, slot, count*dsize);
+        if (data) data += count*dsize;
+        n -= count;
+        offset = 0;
+        k++;
+    }
+}
+
+void* segvector_create(size_t dsize, size_t initial_size, void* initial_values) {
+    return segvector_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* segvector_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                            size_t initial_size, void* initial_values) {
+    uint8_tSegVector vector = gdata_alloc(allocator, sizeof(*vector));
+    if (vector) {
+        vector->size = 0;
+        vector->internal.num_blocks = 0;
+        vector->internal.dsize = dsize;
+        vector->internal.allocator = allocator;
+        if (!grow(vector, initial_size)) {
+            segvector_delete(vector);
+            return NULL;
+        }
+        copy_range(vector, 0, initial_values, initial_size, true);
+        vector->size = initial_size;
+    }
+    return vector;
+}
+
+void segvector_delete(void* vector) {
+    uint8_tSegVector v = vector;
+    size_t dsize = v->internal.dsize;
+    for (size_t k = 0; k < v->internal.num_blocks; k++)
+        gdata_free(v->internal.allocator, v->internal.blocks[k], block_length(k) * dsize);
+    gdata_free(v->internal.allocator, v, sizeof(*v));
+}
+
+void segvector_pushback(void* vector, size_t num_elements, void* data) {
+    uint8_tSegVector v = vector;
+    if (!grow(v, v->size + num_elements))
+        return;
+    if (data) copy_range(v, v->size, data, num_elements, true);
+    v->size += num_elements;
+}
+
+void* segvector_popback(void* vector) {
+    uint8_tSegVector v = vector;
+    v->size--;
+    return segvector_at(v, v->size);
+}
+
+void* segvector_at(const void* vector, size_t index) {
+    const struct uint8_t_segvector* v = vector;
+    size_t offset;
+    size_t k = block_of(index, &offset);
+    return v->internal.blocks[k] + offset*v->internal.dsize;
+}
+
+void segvector_reserve(void* vector, size_t capacity) {
+    grow(vector, capacity);
+}
+
+void segvector_shrink(void* vector) {
+    uint8_tSegVector v = vector;
+    while (v->internal.num_blocks && capacity_of(v->internal.num_blocks - 1) >= v->size) {
+        size_t k = --v->internal.num_blocks;
+        gdata_free(v->internal.allocator, v->internal.blocks[k], block_length(k) * v->internal.dsize);
+    }
+}
+
+void segvector_clear(void* vector) {
+    ((uint8_tSegVector)vector)->size = 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * Generic Segmented Vector
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Elements live in blocks that double in size, found through a fixed
+ * directory. Growing only allocates a new block: elements never move,
+ * so their addresses stay valid until they are popped.
+ *
+ * usage:
+ *      call `SEGVECTOR_TYPEDEF(type)` and
+ *      use `typeSegVector` as your segmented vector
+ */
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include "allocator.h"
+
+// The first block holds 2^SEGVECTOR_FIRST_BITS elements, each next one twice the previous
+#define SEGVECTOR_FIRST_BITS 4
+#define SEGVECTOR_MAX_BLOCKS (64 - SEGVECTOR_FIRST_BITS)
+
+/**
+ * @brief Declare a type of segmented vector and use `typeSegVector`
+ * @usage:
+ *      SEGVECTOR_TYPEDEF(MyType);
+ *      and MyTypeSegVector is now available
+ *
+ * @note: like VECTOR_TYPEDEF, type must be a single name
+ */
+#define SEGVECTOR_TYPEDEF(type)\
+typedef struct type ## _segvector {\
+    size_t size;\
+    struct {\
+        type *blocks[SEGVECTOR_MAX_BLOCKS];\
+        size_t num_blocks;\
+        size_t dsize;\
+        const struct gdata_allocator *allocator;\
+    } internal;\
+} *type ## SegVector
+
+// Declaring basic data segmented vectors
+SEGVECTOR_TYPEDEF(char);
+SEGVECTOR_TYPEDEF(int);
+SEGVECTOR_TYPEDEF(float);
+
+// ===== MACROS ===== //
+
+/**
+ * @brief Creates a new segmented vector with values if passed
+ * @note: You must call `segvector_delete()` later
+ *
+ * @param type: any defined type. ex: int, float, etc...
+ * @param __VA_ARGS__: values to initialize the vector
+ */
+#define SEGVECTOR_CREATE(type, ...) ({\
+    typeof(type) _seg[] = {__VA_ARGS__};\
+    segvector_create(sizeof(type), sizeof(_seg)/sizeof(*_seg), _seg);\
+})
+
+/**
+ * @brief Push one or more values to the vector's end
+ * @param vector: any type of segmented vector
+ * @param __VA_ARGS__: values to push, the type inside vector or literal
+ */
+#define SEGVECTOR_PUSHBACK(vector, ...) ({\
+    typeof(**(vector)->internal.blocks) _seg[] = {__VA_ARGS__};\
+    segvector_pushback(vector, sizeof(_seg)/sizeof(*_seg), _seg);\
+})
+
+/**
+ * @brief Get the last element and remove it from the vector
+ * @return value
+ */
+#define SEGVECTOR_POPBACK(vector) (*(typeof(*(vector)->internal.blocks))segvector_popback(vector))
+
+/**
+ * @brief Element at index, can be assigned
+ * @ex: SEGVECTOR_AT(vector, 0) = 10;
+ */
+#define SEGVECTOR_AT(vector, index) (*(typeof(*(vector)->internal.blocks))segvector_at(vector, index))
+
+// ===== FUNCTIONS ===== //
+
+/**
+ * @brief Create segmented vector and pass values
+ *
+ * @param dsize: size of each element in bytes
+ * @param initial_size: initial size of the vector. (0 is valid)
+ * @param initial_values: pointer to data that will be pushed first.
+ * if NULL, the elements are set to zero
+ */
+void* segvector_create(size_t dsize, size_t initial_size, void* initial_values);
+
+/// @brief Like segvector_create(), the vector and its blocks are allocated by `allocator`
+void* segvector_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                            size_t initial_size, void* initial_values);
+
+// Destructor
+void segvector_delete(void* vector);
+
+/**
+ * @brief Push data to the vector's end. Existing elements are not moved
+ *
+ * @param num_elements: number of elements in data
+ * @param data: array with values to be pushed (values will be copied)
+ *
+ * @see SEGVECTOR_PUSHBACK() macro
+ */
+void segvector_pushback(void* vector, size_t num_elements, void* data);
+
+/**
+ * @brief Pop the vector's last element
+ * @returns: reference to value, valid until the next push
+ * @see SEGVECTOR_POPBACK()
+ */
+void* segvector_popback(void* vector);
+
+// Get a pointer to the given index, O(1)
+void* segvector_at(const void* vector, size_t index);
+
+/**
+ * @brief Allocate blocks for `capacity` elements,
+ * pushing up to that size does not allocate
+ */
+void segvector_reserve(void* vector, size_t capacity);
+
+// Free the blocks not holding any element
+void segvector_shrink(void* vector);
+
+// Remove all elements, keeping the blocks
+void segvector_clear(void* vector);
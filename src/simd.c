@@ -0,0 +1,590 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#define SSE4 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_ARM
+#endif
+
+/*
+ * One implementation of every kernel for each instruction set.
+ * The public functions call the table chosen for the running CPU
+ */
+struct simd_kernels {
+    size_t (*find_int)(const int*, size_t, int);
+    size_t (*find_float)(const float*, size_t, float);
+    size_t (*count_int)(const int*, size_t, int);
+    size_t (*count_float)(const float*, size_t, float);
+    int (*min_int)(const int*, size_t);
+    float (*min_float)(const float*, size_t);
+    int (*max_int)(const int*, size_t);
+    float (*max_float)(const float*, size_t);
+    int64_t (*sum_int)(const int*, size_t);
+    float (*sum_float)(const float*, size_t);
+    int64_t (*dot_int)(const int*, const int*, size_t);
+    float (*dot_float)(const float*, const float*, size_t);
+    bool (*any_equal_int)(const int*, const int*, size_t);
+    bool (*any_equal_float)(const float*, const float*, size_t);
+};
+
+#define KERNELS_TABLE(prefix) {\
+    prefix##_find_int, prefix##_find_float,\
+    prefix##_count_int, prefix##_count_float,\
+    prefix##_min_int, prefix##_min_float,\
+    prefix##_max_int, prefix##_max_float,\
+    prefix##_sum_int, prefix##_sum_float,\
+    prefix##_dot_int, prefix##_dot_float,\
+    prefix##_any_equal_int, prefix##_any_equal_float,\
+}
+
+// ===== SCALAR ===== //
+
+/*
+ * Plain loops, also used for the elements left
+ * after the last full vector in the other kernels
+ */
+#define SCALAR_KERNELS(type, sum_type)\
+static size_t scalar_find_##type(const type* values, size_t n, type value) {\
+    for (size_t i = 0; i < n; i++)\
+        if (values[i] == value) return i;\
+    return n;\
+}\
+static size_t scalar_count_##type(const type* values, size_t n, type value) {\
+    size_t count = 0;\
+    for (size_t i = 0; i < n; i++)\
+        count += values[i] == value;\
+    return count;\
+}\
+static type scalar_min_##type(const type* values, size_t n) {\
+    type min = values[0];\
+    for (size_t i = 1; i < n; i++)\
+        min = values[i] < min ? values[i] : min;\
+    return min;\
+}\
+static type scalar_max_##type(const type* values, size_t n) {\
+    type max = values[0];\
+    for (size_t i = 1; i < n; i++)\
+        max = values[i] > max ? values[i] : max;\
+    return max;\
+}\
+static sum_type scalar_sum_##type(const type* values, size_t n) {\
+    sum_type sum = 0;\
+    for (size_t i = 0; i < n; i++)\
+        sum += values[i];\
+    return sum;\
+}\
+static sum_type scalar_dot_##type(const type* a, const type* b, size_t n) {\
+    sum_type sum = 0;\
+    for (size_t i = 0; i < n; i++)\
+        sum += (sum_type)a[i] * b[i];\
+    return sum;\
+}\
+static bool scalar_any_equal_##type(const type* a, const type* b, size_t n) {\
+    for (size_t i = 0; i < n; i++)\
+        if (a[i] == b[i]) return true;\
+    return false;\
+}
+
+SCALAR_KERNELS(int, int64_t)
+SCALAR_KERNELS(float, float)
+
+static const struct simd_kernels scalar_kernels = KERNELS_TABLE(scalar);
+
+#ifdef SIMD_X86
+// ===== SSE4.1 ===== //
+
+SSE4 static size_t sse4_find_int(const int* values, size_t n, int value) {
+    __m128i target = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(values + i)), target);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scalar_find_int(values + i, n - i, value);
+}
+
+SSE4 static size_t sse4_find_float(const float* values, size_t n, float value) {
+    __m128 target = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), target));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scalar_find_float(values + i, n - i, value);
+}
+
+SSE4 static size_t sse4_count_int(const int* values, size_t n, int value) {
+    __m128i target = _mm_set1_epi32(value);
+    size_t i = 0, count = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(values + i)), target);
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+    }
+    return count + scalar_count_int(values + i, n - i, value);
+}
+
+SSE4 static size_t sse4_count_float(const float* values, size_t n, float value) {
+    __m128 target = _mm_set1_ps(value);
+    size_t i = 0, count = 0;
+    for (; i + 4 <= n; i += 4)
+        count += __builtin_popcount(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), target)));
+    return count + scalar_count_float(values + i, n - i, value);
+}
+
+// Lanes are reduced with the scalar kernel, together with the remaining elements
+#define SSE4_MINMAX(name, type, vtype, load, set1, op, store)\
+SSE4 static type sse4_##name(const type* values, size_t n) {\
+    vtype acc = set1(values[0]);\
+    size_t i = 0;\
+    for (; i + 4 <= n; i += 4)\
+        acc = op(load(values + i), acc);\
+    type lanes[4 + 4];\
+    store(lanes, acc);\
+    size_t rest = n - i;\
+    for (size_t j = 0; j < rest; j++)\
+        lanes[4 + j] = values[i + j];\
+    return scalar_##name(lanes, 4 + rest);\
+}
+
+#define LOADI(p) _mm_loadu_si128((const __m128i*)(p))
+#define STOREI(p, v) _mm_storeu_si128((__m128i*)(p), v)
+SSE4_MINMAX(min_int, int, __m128i, LOADI, _mm_set1_epi32, _mm_min_epi32, STOREI)
+SSE4_MINMAX(max_int, int, __m128i, LOADI, _mm_set1_epi32, _mm_max_epi32, STOREI)
+SSE4_MINMAX(min_float, float, __m128, _mm_loadu_ps, _mm_set1_ps, _mm_min_ps, _mm_storeu_ps)
+SSE4_MINMAX(max_float, float, __m128, _mm_loadu_ps, _mm_set1_ps, _mm_max_ps, _mm_storeu_ps)
+#undef LOADI
+#undef STOREI
+
+SSE4 static int64_t sse4_sum_int(const int* values, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_unpackhi_epi64(v, v)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] + scalar_sum_int(values + i, n - i);
+}
+
+SSE4 static float sse4_sum_float(const float* values, size_t n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_loadu_ps(values + i));
+        acc1 = _mm_add_ps(acc1, _mm_loadu_ps(values + i + 4));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_sum_float(values + i, n - i);
+}
+
+SSE4 static int64_t sse4_dot_int(const int* a, const int* b, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        // signed 32x32 -> 64 bits products of even, then odd lanes
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(va, vb));
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(_mm_srli_epi64(va, 32), _mm_srli_epi64(vb, 32)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] + scalar_dot_int(a + i, b + i, n - i);
+}
+
+SSE4 static float sse4_dot_float(const float* a, const float* b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_dot_float(a + i, b + i, n - i);
+}
+
+SSE4 static bool sse4_any_equal_int(const int* a, const int* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)),
+                                     _mm_loadu_si128((const __m128i*)(b + i)));
+        if (!_mm_testz_si128(eq, eq)) return true;
+    }
+    return scalar_any_equal_int(a + i, b + i, n - i);
+}
+
+SSE4 static bool sse4_any_equal_float(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))))
+            return true;
+    return scalar_any_equal_float(a + i, b + i, n - i);
+}
+
+static const struct simd_kernels sse4_kernels = KERNELS_TABLE(sse4);
+
+// ===== AVX2 ===== //
+
+AVX2 static size_t avx2_find_int(const int* values, size_t n, int value) {
+    __m256i target = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(values + i)), target);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scalar_find_int(values + i, n - i, value);
+}
+
+AVX2 static size_t avx2_find_float(const float* values, size_t n, float value) {
+    __m256 target = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), target, _CMP_EQ_OQ));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scalar_find_float(values + i, n - i, value);
+}
+
+AVX2 static size_t avx2_count_int(const int* values, size_t n, int value) {
+    __m256i target = _mm256_set1_epi32(value);
+    size_t i = 0, count = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(values + i)), target);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+    }
+    return count + scalar_count_int(values + i, n - i, value);
+}
+
+AVX2 static size_t avx2_count_float(const float* values, size_t n, float value) {
+    __m256 target = _mm256_set1_ps(value);
+    size_t i = 0, count = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(values + i), target, _CMP_EQ_OQ);
+        count += __builtin_popcount(_mm256_movemask_ps(eq));
+    }
+    return count + scalar_count_float(values + i, n - i, value);
+}
+
+#define AVX2_MINMAX(name, type, vtype, load, set1, op, store)\
+AVX2 static type avx2_##name(const type* values, size_t n) {\
+    vtype acc0 = set1(values[0]), acc1 = acc0;\
+    size_t i = 0;\
+    for (; i + 16 <= n; i += 16) {\
+        acc0 = op(load(values + i), acc0);\
+        acc1 = op(load(values + i + 8), acc1);\
+    }\
+    type lanes[8 + 16];\
+    store(lanes, op(acc0, acc1));\
+    size_t rest = n - i;\
+    for (size_t j = 0; j < rest; j++)\
+        lanes[8 + j] = values[i + j];\
+    return scalar_##name(lanes, 8 + rest);\
+}
+
+#define LOADI(p) _mm256_loadu_si256((const __m256i*)(p))
+#define STOREI(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+AVX2_MINMAX(min_int, int, __m256i, LOADI, _mm256_set1_epi32, _mm256_min_epi32, STOREI)
+AVX2_MINMAX(max_int, int, __m256i, LOADI, _mm256_set1_epi32, _mm256_max_epi32, STOREI)
+AVX2_MINMAX(min_float, float, __m256, _mm256_loadu_ps, _mm256_set1_ps, _mm256_min_ps, _mm256_storeu_ps)
+AVX2_MINMAX(max_float, float, __m256, _mm256_loadu_ps, _mm256_set1_ps, _mm256_max_ps, _mm256_storeu_ps)
+#undef LOADI
+#undef STOREI
+
+AVX2 static int64_t avx2_sum_int(const int* values, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar_sum_int(values + i, n - i);
+}
+
+AVX2 static float avx2_sum_float(const float* values, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(values + i));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(values + i + 8));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+    float sum = 0;
+    for (int j = 0; j < 8; j++)
+        sum += lanes[j];
+    return sum + scalar_sum_float(values + i, n - i);
+}
+
+AVX2 static int64_t avx2_dot_int(const int* a, const int* b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(va, vb));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar_dot_int(a + i, b + i, n - i);
+}
+
+AVX2 static float avx2_dot_float(const float* a, const float* b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+    float sum = 0;
+    for (int j = 0; j < 8; j++)
+        sum += lanes[j];
+    return sum + scalar_dot_float(a + i, b + i, n - i);
+}
+
+AVX2 static bool avx2_any_equal_int(const int* a, const int* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                        _mm256_loadu_si256((const __m256i*)(b + i)));
+        if (!_mm256_testz_si256(eq, eq)) return true;
+    }
+    return scalar_any_equal_int(a + i, b + i, n - i);
+}
+
+AVX2 static bool avx2_any_equal_float(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _CMP_EQ_OQ)))
+            return true;
+    return scalar_any_equal_float(a + i, b + i, n - i);
+}
+
+static const struct simd_kernels avx2_kernels = KERNELS_TABLE(avx2);
+#endif // SIMD_X86
+
+#ifdef SIMD_ARM
+// ===== NEON ===== //
+
+static size_t neon_find_int(const int* values, size_t n, int value) {
+    int32x4_t target = vdupq_n_s32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (vmaxvq_u32(vceqq_s32(vld1q_s32(values + i), target)))
+            break;
+    return i + scalar_find_int(values + i, n - i, value);
+}
+
+static size_t neon_find_float(const float* values, size_t n, float value) {
+    float32x4_t target = vdupq_n_f32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (vmaxvq_u32(vceqq_f32(vld1q_f32(values + i), target)))
+            break;
+    return i + scalar_find_float(values + i, n - i, value);
+}
+
+static size_t neon_count_int(const int* values, size_t n, int value) {
+    int32x4_t target = vdupq_n_s32(value);
+    size_t i = 0, count = 0;
+    for (; i + 4 <= n; i += 4)
+        count += vaddvq_u32(vshrq_n_u32(vceqq_s32(vld1q_s32(values + i), target), 31));
+    return count + scalar_count_int(values + i, n - i, value);
+}
+
+static size_t neon_count_float(const float* values, size_t n, float value) {
+    float32x4_t target = vdupq_n_f32(value);
+    size_t i = 0, count = 0;
+    for (; i + 4 <= n; i += 4)
+        count += vaddvq_u32(vshrq_n_u32(vceqq_f32(vld1q_f32(values + i), target), 31));
+    return count + scalar_count_float(values + i, n - i, value);
+}
+
+#define NEON_MINMAX(name, type, vtype, load, dup, op, reduce)\
+static type neon_##name(const type* values, size_t n) {\
+    vtype acc = dup(values[0]);\
+    size_t i = 0;\
+    for (; i + 4 <= n; i += 4)\
+        acc = op(load(values + i), acc);\
+    type lanes[1 + 4] = {reduce(acc)};\
+    size_t rest = n - i;\
+    for (size_t j = 0; j < rest; j++)\
+        lanes[1 + j] = values[i + j];\
+    return scalar_##name(lanes, 1 + rest);\
+}
+
+NEON_MINMAX(min_int, int, int32x4_t, vld1q_s32, vdupq_n_s32, vminq_s32, vminvq_s32)
+NEON_MINMAX(max_int, int, int32x4_t, vld1q_s32, vdupq_n_s32, vmaxq_s32, vmaxvq_s32)
+NEON_MINMAX(min_float, float, float32x4_t, vld1q_f32, vdupq_n_f32, vminnmq_f32, vminnmvq_f32)
+NEON_MINMAX(max_float, float, float32x4_t, vld1q_f32, vdupq_n_f32, vmaxnmq_f32, vmaxnmvq_f32)
+
+static int64_t neon_sum_int(const int* values, size_t n) {
+    int64x2_t acc = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = vpadalq_s32(acc, vld1q_s32(values + i));
+    return vaddvq_s64(acc) + scalar_sum_int(values + i, n - i);
+}
+
+static float neon_sum_float(const float* values, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vaddq_f32(acc0, vld1q_f32(values + i));
+        acc1 = vaddq_f32(acc1, vld1q_f32(values + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + scalar_sum_float(values + i, n - i);
+}
+
+static int64_t neon_dot_int(const int* a, const int* b, size_t n) {
+    int64x2_t acc = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t va = vld1q_s32(a + i), vb = vld1q_s32(b + i);
+        acc = vmlal_s32(acc, vget_low_s32(va), vget_low_s32(vb));
+        acc = vmlal_high_s32(acc, va, vb);
+    }
+    return vaddvq_s64(acc) + scalar_dot_int(a + i, b + i, n - i);
+}
+
+static float neon_dot_float(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + scalar_dot_float(a + i, b + i, n - i);
+}
+
+static bool neon_any_equal_int(const int* a, const int* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (vmaxvq_u32(vceqq_s32(vld1q_s32(a + i), vld1q_s32(b + i))))
+            return true;
+    return scalar_any_equal_int(a + i, b + i, n - i);
+}
+
+static bool neon_any_equal_float(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (vmaxvq_u32(vceqq_f32(vld1q_f32(a + i), vld1q_f32(b + i))))
+            return true;
+    return scalar_any_equal_float(a + i, b + i, n - i);
+}
+
+static const struct simd_kernels neon_kernels = KERNELS_TABLE(neon);
+#endif // SIMD_ARM
+
+// ===== DISPATCH ===== //
+
+static const struct simd_kernels* kernels = &scalar_kernels;
+static enum SimdLevel level = SIMD_SCALAR;
+
+static const struct simd_kernels* kernels_for(enum SimdLevel l) {
+    switch (l) {
+    case SIMD_SCALAR:
+        return &scalar_kernels;
+#ifdef SIMD_X86
+    case SIMD_SSE4:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1") ? &sse4_kernels : NULL;
+    case SIMD_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#endif
+#ifdef SIMD_ARM
+    case SIMD_NEON:
+        return &neon_kernels;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// Pick the best instruction set once, before main()
+__attribute__((constructor))
+static void simd_init(void) {
+    enum SimdLevel best[] = {SIMD_AVX2, SIMD_NEON, SIMD_SSE4};
+    for (size_t i = 0; i < sizeof(best)/sizeof(*best); i++)
+        if (simd_set_level(best[i]))
+            return;
+}
+
+enum SimdLevel simd_level(void) {
+    return level;
+}
+
+bool simd_set_level(enum SimdLevel l) {
+    const struct simd_kernels* k = kernels_for(l);
+    if (k == NULL)
+        return false;
+    kernels = k;
+    level = l;
+    return true;
+}
+
+// ===== FUNCTIONS ===== //
+
+size_t simd_find_int(const int* values, size_t n, int value) {
+    return kernels->find_int(values, n, value);
+}
+size_t simd_find_float(const float* values, size_t n, float value) {
+    return kernels->find_float(values, n, value);
+}
+
+size_t simd_count_int(const int* values, size_t n, int value) {
+    return kernels->count_int(values, n, value);
+}
+size_t simd_count_float(const float* values, size_t n, float value) {
+    return kernels->count_float(values, n, value);
+}
+
+int simd_min_int(const int* values, size_t n) {
+    return kernels->min_int(values, n);
+}
+float simd_min_float(const float* values, size_t n) {
+    return kernels->min_float(values, n);
+}
+int simd_max_int(const int* values, size_t n) {
+    return kernels->max_int(values, n);
+}
+float simd_max_float(const float* values, size_t n) {
+    return kernels->max_float(values, n);
+}
+
+int64_t simd_sum_int(const int* values, size_t n) {
+    return kernels->sum_int(values, n);
+}
+float simd_sum_float(const float* values, size_t n) {
+    return kernels->sum_float(values, n);
+}
+
+int64_t simd_dot_int(const int* a, const int* b, size_t n) {
+    return kernels->dot_int(a, b, n);
+}
+float simd_dot_float(const float* a, const float* b, size_t n) {
+    return kernels->dot_float(a, b, n);
+}
+
+bool simd_any_equal_int(const int* a, const int* b, size_t n) {
+    return kernels->any_equal_int(a, b, n);
+}
+bool simd_any_equal_float(const float* a, const float* b, size_t n) {
+    return kernels->any_equal_float(a, b, n);
+}
@@ -0,0 +1,107 @@
+/**
+ * Vectorized kernels
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Search, count and reductions on int and float sequences, using
+ * AVX2, SSE4.1 or NEON when the running CPU has them (checked once,
+ * at load time) and plain loops otherwise.
+ *
+ * usage:
+ *      size_t i = ARRAY_FIND(vector, 10);
+ *      float total = ARRAY_SUM(floats);
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Instruction sets used by the kernels
+ */
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_SSE4,
+    SIMD_AVX2,
+    SIMD_NEON,
+};
+
+// ===== MACROS ===== //
+
+/*
+ * For array based structures of int or float (Array, Vector),
+ * like ARRAY_FOR() in utils.h
+ */
+
+/// @brief Index of the first element equal to value, or size if not found
+#define ARRAY_FIND(array, value) _Generic((array)->at,\
+    int*: simd_find_int, float*: simd_find_float)((array)->at, (array)->size, value)
+
+/// @brief Number of elements equal to value
+#define ARRAY_COUNT(array, value) _Generic((array)->at,\
+    int*: simd_count_int, float*: simd_count_float)((array)->at, (array)->size, value)
+
+/// @brief Smallest element, the structure must not be empty
+#define ARRAY_MIN(array) _Generic((array)->at,\
+    int*: simd_min_int, float*: simd_min_float)((array)->at, (array)->size)
+
+/// @brief Biggest element, the structure must not be empty
+#define ARRAY_MAX(array) _Generic((array)->at,\
+    int*: simd_max_int, float*: simd_max_float)((array)->at, (array)->size)
+
+/// @brief Sum of the elements, int64_t for ints
+#define ARRAY_SUM(array) _Generic((array)->at,\
+    int*: simd_sum_int, float*: simd_sum_float)((array)->at, (array)->size)
+
+/// @brief Dot product of two structures of the same size, int64_t for ints
+#define ARRAY_DOT(a, b) _Generic((a)->at,\
+    int*: simd_dot_int, float*: simd_dot_float)((a)->at, (b)->at, (a)->size)
+
+/// @brief Check if a->at[i] == b->at[i] for some i, both with the same size
+#define ARRAY_ANY_EQUAL(a, b) _Generic((a)->at,\
+    int*: simd_any_equal_int, float*: simd_any_equal_float)((a)->at, (b)->at, (a)->size)
+
+// ===== FUNCTIONS ===== //
+
+/// @brief Instruction set in use
+enum SimdLevel simd_level(void);
+
+/**
+ * @brief Use another instruction set, for tests and benchmarks
+ * @return false if the CPU does not support it
+ */
+bool simd_set_level(enum SimdLevel level);
+
+/// @brief Index of the first element equal to value, or n if not found
+size_t simd_find_int(const int* values, size_t n, int value);
+size_t simd_find_float(const float* values, size_t n, float value);
+
+/// @brief Number of elements equal to value
+size_t simd_count_int(const int* values, size_t n, int value);
+size_t simd_count_float(const float* values, size_t n, float value);
+
+/**
+ * @brief Smallest and biggest element, n must be > 0
+ * @note NaNs are skipped when values[0] is not NaN
+ */
+int simd_min_int(const int* values, size_t n);
+float simd_min_float(const float* values, size_t n);
+int simd_max_int(const int* values, size_t n);
+float simd_max_float(const float* values, size_t n);
+
+/**
+ * @brief Sum of the elements
+ * @note ints are added as int64_t. floats are added in several
+ * partial sums, the rounding may differ from a sequential loop
+ */
+int64_t simd_sum_int(const int* values, size_t n);
+float simd_sum_float(const float* values, size_t n);
+
+/// @brief Sum of a[i] * b[i]. Like the sum, ints are added as int64_t
+int64_t simd_dot_int(const int* a, const int* b, size_t n);
+float simd_dot_float(const float* a, const float* b, size_t n);
+
+/// @brief Check if a[i] == b[i] for some i
+bool simd_any_equal_int(const int* a, const int* b, size_t n);
+bool simd_any_equal_float(const float* a, const float* b, size_t n);
@@ -0,0 +1,605 @@
+#include "sort.h"
+#include "utils/threads.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Ranges smaller than this are sorted with insertion sort
+#define SORT_INSERTION_THRESHOLD 24
+
+// Ranges bigger than this take the pivot as median of 3 medians
+#define SORT_NINTHER_THRESHOLD 128
+
+// Elements moved before giving up the partial insertion sort
+#define SORT_PARTIAL_INSERTION_LIMIT 8
+
+// Below this size comparisons beat the radix sort passes
+#define SORT_RADIX_THRESHOLD 256
+
+// Below this size gdata_parallel_sort() does not start threads
+#define SORT_PARALLEL_THRESHOLD (1 << 16)
+
+// Most threads started by gdata_parallel_sort()
+#define SORT_MAX_THREADS 256
+
+// Buckets per thread in the parallel sort, more buckets balance the work better
+#define SORT_BUCKETS_PER_THREAD 8
+
+// Samples taken per bucket to choose the splitters
+#define SORT_OVERSAMPLING 32
+
+/*
+ * Elements are handled as bytes. The element size is fixed for a
+ * whole sort, so the switch is predicted and common sizes do not
+ * call memcpy with a variable size
+ */
+struct sorter {
+    comparator cmp;
+    size_t dsize;
+    uint8_t *pivot, *tmp;
+};
+
+static inline void elem_copy(uint8_t* dst, const uint8_t* src, size_t dsize) {
+    switch (dsize) {
+    case 4: memcpy(dst, src, 4); break;
+    case 8: memcpy(dst, src, 8); break;
+    default: memcpy(dst, src, dsize);
+    }
+}
+
+static inline void elem_swap(struct sorter* s, uint8_t* a, uint8_t* b) {
+    elem_copy(s->tmp, a, s->dsize);
+    elem_copy(a, b, s->dsize);
+    elem_copy(b, s->tmp, s->dsize);
+}
+
+static inline bool less(struct sorter* s, uint8_t* a, uint8_t* b) {
+    return s->cmp(a, b) < 0;
+}
+
+// ===== SMALL RANGES ===== //
+
+// Insertion sort, `guarded` is false when an element before begin is <= all in range
+static void insertion_sort(struct sorter* s, uint8_t* begin, uint8_t* end, bool guarded) {
+    size_t dsize = s->dsize;
+    if (begin == end)
+        return;
+    for (uint8_t* cur = begin + dsize; cur != end; cur += dsize) {
+        uint8_t* sift = cur;
+        if (less(s, sift, sift - dsize)) {
+            elem_copy(s->pivot, sift, dsize);
+            do {
+                elem_copy(sift, sift - dsize, dsize);
+                sift -= dsize;
+            } while ((!guarded || sift != begin) && less(s, s->pivot, sift - dsize));
+            elem_copy(sift, s->pivot, dsize);
+        }
+    }
+}
+
+/*
+ * Insertion sort that gives up after a few elements moved.
+ * Returns true if the range got sorted
+ */
+static bool partial_insertion_sort(struct sorter* s, uint8_t* begin, uint8_t* end) {
+    size_t dsize = s->dsize, moved = 0;
+    if (begin == end)
+        return true;
+    for (uint8_t* cur = begin + dsize; cur != end; cur += dsize) {
+        uint8_t* sift = cur;
+        if (less(s, sift, sift - dsize)) {
+            elem_copy(s->pivot, sift, dsize);
+            do {
+                elem_copy(sift, sift - dsize, dsize);
+                sift -= dsize;
+            } while (sift != begin && less(s, s->pivot, sift - dsize));
+            elem_copy(sift, s->pivot, dsize);
+            moved += (cur - sift) / dsize;
+        }
+        if (moved > SORT_PARTIAL_INSERTION_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+static inline void sort2(struct sorter* s, uint8_t* a, uint8_t* b) {
+    if (less(s, b, a))
+        elem_swap(s, a, b);
+}
+
+static inline void sort3(struct sorter* s, uint8_t* a, uint8_t* b, uint8_t* c) {
+    sort2(s, a, b);
+    sort2(s, b, c);
+    sort2(s, a, b);
+}
+
+static void sift_down(struct sorter* s, uint8_t* begin, size_t root, size_t n) {
+    size_t dsize = s->dsize;
+    while (2*root + 1 < n) {
+        size_t child = 2*root + 1;
+        if (child + 1 < n && less(s, begin + child*dsize, begin + (child+1)*dsize))
+            child++;
+        if (!less(s, begin + root*dsize, begin + child*dsize))
+            return;
+        elem_swap(s, begin + root*dsize, begin + child*dsize);
+        root = child;
+    }
+}
+
+// Fallback keeping the worst case O(n log n)
+static void heap_sort(struct sorter* s, uint8_t* begin, size_t n) {
+    for (size_t root = n/2; root-- > 0;)
+        sift_down(s, begin, root, n);
+    for (size_t end = n; end-- > 1;) {
+        elem_swap(s, begin, begin + end*s->dsize);
+        sift_down(s, begin, 0, end);
+    }
+}
+
+// ===== PARTITIONING ===== //
+
+/*
+ * Partition around *begin, elements equal to the pivot go to the right.
+ * Returns the pivot's final position, `already_partitioned` is set
+ * when no element had to be swapped
+ */
+static uint8_t* partition_right(struct sorter* s, uint8_t* begin, uint8_t* end, bool* already_partitioned) {
+    size_t dsize = s->dsize;
+    uint8_t* pivot = s->pivot;
+    elem_copy(pivot, begin, dsize);
+    uint8_t *first = begin, *last = end;
+
+    // the median of 3 guarantees an element >= pivot on the right
+    do first += dsize; while (less(s, first, pivot));
+
+    if (first - dsize == begin)
+        do last -= dsize; while (first < last && !less(s, last, pivot));
+    else
+        do last -= dsize; while (!less(s, last, pivot));
+
+    *already_partitioned = first >= last;
+    while (first < last) {
+        elem_swap(s, first, last);
+        do first += dsize; while (less(s, first, pivot));
+        do last -= dsize; while (!less(s, last, pivot));
+    }
+
+    uint8_t* pivot_pos = first - dsize;
+    elem_copy(begin, pivot_pos, dsize);
+    elem_copy(pivot_pos, pivot, dsize);
+    return pivot_pos;
+}
+
+/*
+ * Partition around *begin, elements equal to the pivot go to the left.
+ * Used when the pivot equals the element before the range, so the
+ * left side is made only of equal elements and needs no sorting
+ */
+static uint8_t* partition_left(struct sorter* s, uint8_t* begin, uint8_t* end) {
+    size_t dsize = s->dsize;
+    uint8_t* pivot = s->pivot;
+    elem_copy(pivot, begin, dsize);
+    uint8_t *first = begin, *last = end;
+
+    do last -= dsize; while (less(s, pivot, last));
+
+    if (last + dsize == end)
+        do first += dsize; while (first < last && !less(s, pivot, first));
+    else
+        do first += dsize; while (!less(s, pivot, first));
+
+    while (first < last) {
+        elem_swap(s, first, last);
+        do last -= dsize; while (less(s, pivot, last));
+        do first += dsize; while (!less(s, pivot, first));
+    }
+
+    elem_copy(begin, last, dsize);
+    elem_copy(last, pivot, dsize);
+    return last;
+}
+
+// Break patterns of a bad partition by swapping a few elements around
+static void break_patterns(struct sorter* s, uint8_t* begin, uint8_t* end, size_t size) {
+    size_t dsize = s->dsize;
+    if (size < SORT_INSERTION_THRESHOLD)
+        return;
+    size_t quarter = size / 4;
+    elem_swap(s, begin, begin + quarter*dsize);
+    elem_swap(s, end - dsize, end - quarter*dsize);
+    if (size > SORT_NINTHER_THRESHOLD) {
+        elem_swap(s, begin + dsize, begin + (quarter + 1)*dsize);
+        elem_swap(s, begin + 2*dsize, begin + (quarter + 2)*dsize);
+        elem_swap(s, end - 2*dsize, end - (quarter + 1)*dsize);
+        elem_swap(s, end - 3*dsize, end - (quarter + 2)*dsize);
+    }
+}
+
+static void pdqsort_loop(struct sorter* s, uint8_t* begin, uint8_t* end, int bad_allowed, bool leftmost) {
+    size_t dsize = s->dsize;
+    while (true) {
+        size_t size = (end - begin) / dsize;
+        if (size < SORT_INSERTION_THRESHOLD) {
+            insertion_sort(s, begin, end, leftmost);
+            return;
+        }
+
+        // pivot goes to *begin
+        uint8_t* mid = begin + (size/2)*dsize;
+        if (size > SORT_NINTHER_THRESHOLD) {
+            sort3(s, begin, mid, end - dsize);
+            sort3(s, begin + dsize, mid - dsize, end - 2*dsize);
+            sort3(s, begin + 2*dsize, mid + dsize, end - 3*dsize);
+            sort3(s, mid - dsize, mid, mid + dsize);
+            elem_swap(s, begin, mid);
+        } else {
+            sort3(s, mid, begin, end - dsize);
+        }
+
+        // many equal elements: the previous pivot is equal to this one
+        if (!leftmost && !less(s, begin - dsize, begin)) {
+            begin = partition_left(s, begin, end) + dsize;
+            continue;
+        }
+
+        bool already_partitioned;
+        uint8_t* pivot_pos = partition_right(s, begin, end, &already_partitioned);
+        size_t left_size = (pivot_pos - begin) / dsize;
+        size_t right_size = (end - pivot_pos) / dsize - 1;
+
+        if (left_size < size/8 || right_size < size/8) {
+            if (--bad_allowed == 0) {
+                heap_sort(s, begin, size);
+                return;
+            }
+            break_patterns(s, begin, pivot_pos, left_size);
+            break_patterns(s, pivot_pos + dsize, end, right_size);
+        } else if (already_partitioned
+                   && partial_insertion_sort(s, begin, pivot_pos)
+                   && partial_insertion_sort(s, pivot_pos + dsize, end)) {
+            return;
+        }
+
+        // recurse into the left side, loop on the right one
+        pdqsort_loop(s, begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + dsize;
+        leftmost = false;
+    }
+}
+
+// ===== RADIX SORT ===== //
+
+/*
+ * Keys are made unsigned so their order matches the bytes order:
+ * signed integers flip the sign bit, floats flip all bits
+ * when negative and only the sign bit otherwise
+ */
+#define RADIX_KEYS_DEFINE(bits)\
+static inline uint##bits##_t to_key##bits(uint##bits##_t x, enum SortKey key) {\
+    const uint##bits##_t sign = (uint##bits##_t)1 << (bits - 1);\
+    switch (key) {\
+    case SORT_INT32: case SORT_INT64: return x ^ sign;\
+    case SORT_FLOAT: case SORT_DOUBLE: return x & sign ? ~x : x ^ sign;\
+    default: return x;\
+    }\
+}\
+static inline uint##bits##_t from_key##bits(uint##bits##_t x, enum SortKey key) {\
+    const uint##bits##_t sign = (uint##bits##_t)1 << (bits - 1);\
+    switch (key) {\
+    case SORT_INT32: case SORT_INT64: return x ^ sign;\
+    case SORT_FLOAT: case SORT_DOUBLE: return x & sign ? x ^ sign : ~x;\
+    default: return x;\
+    }\
+}\
+static void radix_sort##bits(uint##bits##_t* values, size_t n, uint##bits##_t* buffer, enum SortKey key) {\
+    enum { PASSES = bits / 8 };\
+    size_t counts[PASSES][256] = {{0}};\
+    for (size_t i = 0; i < n; i++) {\
+        uint##bits##_t k = values[i] = to_key##bits(values[i], key);\
+        for (int p = 0; p < PASSES; p++)\
+            counts[p][(k >> 8*p) & 0xff]++;\
+    }\
+    uint##bits##_t *src = values, *dst = buffer;\
+    for (int p = 0; p < PASSES; p++) {\
+        /* skip bytes equal in all keys */\
+        if (counts[p][(src[0] >> 8*p) & 0xff] == n)\
+            continue;\
+        size_t offset = 0;\
+        for (int d = 0; d < 256; d++) {\
+            size_t c = counts[p][d];\
+            counts[p][d] = offset;\
+            offset += c;\
+        }\
+        for (size_t i = 0; i < n; i++)\
+            dst[counts[p][(src[i] >> 8*p) & 0xff]++] = src[i];\
+        uint##bits##_t* t = src; src = dst; dst = t;\
+    }\
+    for (size_t i = 0; i < n; i++)\
+        values[i] = from_key##bits(src[i], key);\
+}
+
+RADIX_KEYS_DEFINE(32)
+RADIX_KEYS_DEFINE(64)
+
+static int uint32cmp(void* a, void* b) {
+    uint32_t x = *(uint32_t*)a, y = *(uint32_t*)b;
+    return (x > y) - (x < y);
+}
+static int int64cmp(void* a, void* b) {
+    int64_t x = *(int64_t*)a, y = *(int64_t*)b;
+    return (x > y) - (x < y);
+}
+static int uint64cmp(void* a, void* b) {
+    uint64_t x = *(uint64_t*)a, y = *(uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Radix sortable numbers, compared by the library comparators. -1 if not
+static int radix_key_of(comparator cmp, size_t dsize) {
+    if (cmp == intcmp && dsize == sizeof(int32_t)) return SORT_INT32;
+    if (cmp == floatcmp && dsize == sizeof(float)) return SORT_FLOAT;
+    if (cmp == doublecmp && dsize == sizeof(double)) return SORT_DOUBLE;
+    return -1;
+}
+
+// ===== PARALLEL SORT ===== //
+
+/*
+ * Sample sort: splitters taken from a sorted sample define the buckets.
+ * Each thread counts and then scatters its slice of the input into a
+ * buffer grouped by bucket, and the buckets are sorted independently
+ * and copied back in place.
+ * When the sample has repeated splitters (frequent keys), every splitter
+ * also gets a bucket for the elements equal to it. Those are already
+ * sorted, so frequent keys neither pile up in one bucket nor get sorted
+ */
+struct parallel_sort {
+    uint8_t* ptr;
+    uint8_t* buffer;
+    size_t n;
+    struct sorter sorter;
+    size_t num_threads;
+    size_t num_ranges;      // buckets between splitters, a power of two
+    size_t num_buckets;     // num_ranges, plus num_ranges - 1 with equal_buckets
+    bool equal_buckets;
+    uint8_t* splitters;     // num_ranges - 1 elements
+    int key;                // enum SortKey of numbers compared by intcmp, floatcmp or doublecmp, or -1
+    uint64_t* key_splitters; // splitters as radix keys, compared without calling cmp
+    size_t* counts;         // elements of each thread in each bucket, then scatter offsets
+    size_t* bucket_start;   // first element of each bucket in `buffer`
+    size_t next_bucket;
+};
+
+struct parallel_sort_worker {
+    struct parallel_sort* sort;
+    size_t id;
+};
+
+static inline uint64_t radix_key(int key, const uint8_t* element) {
+    if (key == SORT_DOUBLE) {
+        uint64_t x;
+        memcpy(&x, element, sizeof(x));
+        return to_key64(x, key);
+    }
+    uint32_t x;
+    memcpy(&x, element, sizeof(x));
+    return to_key32(x, key);
+}
+
+/*
+ * Number of splitters <= element. num_ranges is a power of two,
+ * so the search takes a fixed number of steps and no branches.
+ * With equal_buckets, range r is bucket 2r and the elements equal to
+ * the splitter before it go to bucket 2r - 1
+ */
+static size_t bucket_of(struct parallel_sort* sort, uint8_t* element) {
+    size_t dsize = sort->sorter.dsize;
+    size_t range = 0;
+    bool equal;
+    if (sort->key >= 0) {
+        uint64_t k = radix_key(sort->key, element);
+        for (size_t step = sort->num_ranges / 2; step; step /= 2)
+            range += k >= sort->key_splitters[range + step - 1] ? step : 0;
+        if (!sort->equal_buckets)
+            return range;
+        equal = range && k == sort->key_splitters[range - 1];
+    } else {
+        for (size_t step = sort->num_ranges / 2; step; step /= 2) {
+            uint8_t* splitter = sort->splitters + (range + step - 1)*dsize;
+            range += sort->sorter.cmp(element, splitter) >= 0 ? step : 0;
+        }
+        if (!sort->equal_buckets)
+            return range;
+        equal = range && sort->sorter.cmp(element, sort->splitters + (range - 1)*dsize) == 0;
+    }
+    return 2*range - equal;
+}
+
+static void* parallel_count(void* arg) {
+    struct parallel_sort_worker* worker = arg;
+    struct parallel_sort* sort = worker->sort;
+    size_t dsize = sort->sorter.dsize;
+    size_t* counts = sort->counts + worker->id * sort->num_buckets;
+    size_t end = (worker->id + 1) * sort->n / sort->num_threads;
+    for (size_t i = worker->id * sort->n / sort->num_threads; i < end; i++)
+        counts[bucket_of(sort, sort->ptr + i*dsize)]++;
+    return NULL;
+}
+
+static void* parallel_scatter(void* arg) {
+    struct parallel_sort_worker* worker = arg;
+    struct parallel_sort* sort = worker->sort;
+    size_t dsize = sort->sorter.dsize;
+    size_t* offsets = sort->counts + worker->id * sort->num_buckets;
+    size_t end = (worker->id + 1) * sort->n / sort->num_threads;
+    for (size_t i = worker->id * sort->n / sort->num_threads; i < end; i++) {
+        uint8_t* element = sort->ptr + i*dsize;
+        elem_copy(sort->buffer + offsets[bucket_of(sort, element)]++ * dsize, element, dsize);
+    }
+    return NULL;
+}
+
+static void* parallel_sort_buckets(void* arg) {
+    struct parallel_sort_worker* worker = arg;
+    struct parallel_sort* sort = worker->sort;
+    size_t dsize = sort->sorter.dsize;
+    size_t b;
+    while ((b = __atomic_fetch_add(&sort->next_bucket, 1, __ATOMIC_RELAXED)) < sort->num_buckets) {
+        size_t start = sort->bucket_start[b];
+        size_t size = sort->bucket_start[b + 1] - start;
+        if (!sort->equal_buckets || b % 2 == 0)
+            gdata_sort(sort->buffer + start*dsize, size, dsize, sort->sorter.cmp);
+        memcpy(sort->ptr + start*dsize, sort->buffer + start*dsize, size*dsize);
+    }
+    return NULL;
+}
+
+/*
+ * Sort a sample of the input and take evenly spaced splitters from it,
+ * enabling equal_buckets if some are repeated
+ */
+static bool choose_splitters(struct parallel_sort* sort) {
+    size_t dsize = sort->sorter.dsize;
+    size_t num_samples = sort->num_ranges * SORT_OVERSAMPLING;
+    uint8_t* samples = malloc(num_samples * dsize);
+    if (samples == NULL)
+        return false;
+    // spread the samples over the input, with a random position in each stride
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    size_t stride = sort->n / num_samples;
+    for (size_t i = 0; i < num_samples; i++) {
+        state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+        elem_copy(samples + i*dsize, sort->ptr + (i*stride + state % stride)*dsize, dsize);
+    }
+    gdata_sort(samples, num_samples, dsize, sort->sorter.cmp);
+    sort->equal_buckets = false;
+    for (size_t r = 1; r < sort->num_ranges; r++) {
+        uint8_t* splitter = sort->splitters + (r - 1)*dsize;
+        elem_copy(splitter, samples + r*SORT_OVERSAMPLING*dsize, dsize);
+        if (sort->key >= 0)
+            sort->key_splitters[r - 1] = radix_key(sort->key, splitter);
+        if (r > 1 && sort->sorter.cmp(splitter - dsize, splitter) == 0)
+            sort->equal_buckets = true;
+    }
+    sort->num_buckets = sort->equal_buckets ? 2*sort->num_ranges - 1 : sort->num_ranges;
+    free(samples);
+    return true;
+}
+
+// All splitters equal, most of the input is one key and buckets would not split it
+static bool splitters_collapsed(struct parallel_sort* sort) {
+    size_t dsize = sort->sorter.dsize;
+    uint8_t* last = sort->splitters + (sort->num_ranges - 2)*dsize;
+    return sort->sorter.cmp(sort->splitters, last) == 0;
+}
+
+// ===== FUNCTIONS ===== //
+
+void gdata_sort(void* ptr, size_t n, size_t dsize, comparator cmp) {
+    if (n < 2)
+        return;
+    // numbers compared by the library comparators go to radix sort
+    if (n >= SORT_RADIX_THRESHOLD) {
+        int key = radix_key_of(cmp, dsize);
+        if (key >= 0) {
+            gdata_radix_sort(ptr, n, key);
+            return;
+        }
+    }
+    uint8_t buffers[2*dsize];
+    struct sorter s = {.cmp = cmp, .dsize = dsize, .pivot = buffers, .tmp = buffers + dsize};
+
+    int bad_allowed = 1;
+    for (size_t i = n; i > 1; i >>= 1)
+        bad_allowed++;
+    uint8_t* begin = ptr;
+    pdqsort_loop(&s, begin, begin + n*dsize, bad_allowed, true);
+}
+
+void gdata_radix_sort(void* ptr, size_t n, enum SortKey key) {
+    bool wide = key == SORT_INT64 || key == SORT_UINT64 || key == SORT_DOUBLE;
+    size_t dsize = wide ? 8 : 4;
+    void* buffer = n >= SORT_RADIX_THRESHOLD ? malloc(n * dsize) : NULL;
+    if (buffer == NULL) {
+        static const comparator cmps[] = {
+            [SORT_INT32] = intcmp, [SORT_UINT32] = uint32cmp,
+            [SORT_INT64] = int64cmp, [SORT_UINT64] = uint64cmp,
+            [SORT_FLOAT] = floatcmp, [SORT_DOUBLE] = doublecmp,
+        };
+        uint8_t buffers[2*dsize];
+        struct sorter s = {.cmp = cmps[key], .dsize = dsize, .pivot = buffers, .tmp = buffers + dsize};
+        if (n > 1)
+            pdqsort_loop(&s, ptr, (uint8_t*)ptr + n*dsize, 64, true);
+        return;
+    }
+    if (wide)
+        radix_sort64(ptr, n, buffer, key);
+    else
+        radix_sort32(ptr, n, buffer, key);
+    free(buffer);
+}
+
+void gdata_parallel_sort(void* ptr, size_t n, size_t dsize, comparator cmp, size_t num_threads) {
+    num_threads = gdata_thread_count(num_threads, SORT_MAX_THREADS);
+    if (num_threads == 1 || n < SORT_PARALLEL_THRESHOLD) {
+        gdata_sort(ptr, n, dsize, cmp);
+        return;
+    }
+
+    // a power of two, with enough elements to sample every bucket
+    size_t num_ranges = 2;
+    while (num_ranges < num_threads * SORT_BUCKETS_PER_THREAD
+           && 2*num_ranges <= n / (2*SORT_OVERSAMPLING))
+        num_ranges *= 2;
+    if (num_threads > num_ranges)
+        num_threads = num_ranges;
+
+    struct parallel_sort sort = {
+        .ptr = ptr,
+        .n = n,
+        .sorter = {.cmp = cmp, .dsize = dsize},
+        .num_threads = num_threads,
+        .num_ranges = num_ranges,
+        .key = radix_key_of(cmp, dsize),
+        .buffer = malloc(n * dsize),
+    };
+    // room for the equal buckets, enabled after sampling
+    sort.splitters = malloc(num_ranges * dsize);
+    sort.key_splitters = malloc(num_ranges * sizeof(uint64_t));
+    sort.counts = calloc(num_threads * 2*num_ranges, sizeof(size_t));
+    sort.bucket_start = malloc((2*num_ranges + 1) * sizeof(size_t));
+    struct parallel_sort_worker* workers = malloc(num_threads * sizeof(*workers));
+
+    // without memory for the buffers the sort is done in place
+    bool failed = !sort.buffer || !sort.splitters || !sort.key_splitters || !sort.counts ||
+                  !sort.bucket_start || !workers || !choose_splitters(&sort);
+    if (failed || splitters_collapsed(&sort)) {
+        gdata_sort(ptr, n, dsize, cmp);
+    } else {
+        for (size_t t = 0; t < num_threads; t++)
+            workers[t] = (struct parallel_sort_worker){.sort = &sort, .id = t};
+        gdata_run_threads(NULL, workers, sizeof(*workers), num_threads, parallel_count);
+
+        // counts become the offsets where each thread scatters its elements
+        size_t offset = 0;
+        for (size_t b = 0; b < sort.num_buckets; b++) {
+            sort.bucket_start[b] = offset;
+            for (size_t t = 0; t < num_threads; t++) {
+                size_t count = sort.counts[t * sort.num_buckets + b];
+                sort.counts[t * sort.num_buckets + b] = offset;
+                offset += count;
+            }
+        }
+        sort.bucket_start[sort.num_buckets] = offset;
+        gdata_run_threads(NULL, workers, sizeof(*workers), num_threads, parallel_scatter);
+        gdata_run_threads(NULL, workers, sizeof(*workers), num_threads, parallel_sort_buckets);
+    }
+
+    free(workers);
+    free(sort.buffer);
+    free(sort.splitters);
+    free(sort.key_splitters);
+    free(sort.counts);
+    free(sort.bucket_start);
+}
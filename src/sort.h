@@ -0,0 +1,61 @@
+/**
+ * Generic Sorting
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ *
+ * Pattern-defeating quicksort for any element type and
+ * LSD radix sort for integer and floating point elements.
+ *
+ * usage:
+ *      gdata_sort(values, n, sizeof(*values), intcmp);
+ *      array_sort(array, floatcmp);
+ *      vector_sort(vector, my_comparator);
+ */
+#pragma once
+#include <stddef.h>
+#include "heap.h"
+
+/**
+ * Element types handled by gdata_radix_sort()
+ */
+enum SortKey {
+    SORT_INT32,
+    SORT_UINT32,
+    SORT_INT64,
+    SORT_UINT64,
+    SORT_FLOAT,
+    SORT_DOUBLE,
+};
+
+/**
+ * @brief Sort `n` elements of `dsize` bytes in ascending order (not stable).
+ * O(n log n) in the worst case, O(n) for sorted, reversed or equal inputs
+ *
+ * @param ptr: first element
+ * @param cmp: comparator, like the ones given to heap_create(). ex: intcmp
+ *
+ * @note with intcmp, floatcmp or doublecmp large inputs use gdata_radix_sort()
+ */
+void gdata_sort(void* ptr, size_t n, size_t dsize, comparator cmp);
+
+/**
+ * @brief Sort like gdata_sort() using many threads.
+ * Uses a temporary buffer of `n` elements.
+ *
+ * @param num_threads: number of threads, including the calling one.
+ * 0 uses one per online processor
+ *
+ * @note small inputs are sorted by the calling thread only
+ */
+void gdata_parallel_sort(void* ptr, size_t n, size_t dsize, comparator cmp, size_t num_threads);
+
+/**
+ * @brief Sort numbers in ascending order, in linear time.
+ * Uses a temporary buffer of `n` elements.
+ *
+ * @param key: type of the elements. see: enum SortKey
+ *
+ * @note the position of NaNs is unspecified
+ */
+void gdata_radix_sort(void* ptr, size_t n, enum SortKey key);
@@ -2,10 +2,23 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Bytes of each node, the same as sizeof() of the nodes of STACK_TYPEDEF stacks
+static size_t node_size(const Stack* s) {
+    size_t size = sizeof(struct stack_node) + s->internal.dsize;
+    return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
 void* stack_create(size_t dsize, size_t initial_size, void *initial_values) {
-    Stack res = {.internal.dsize=dsize};
-    Stack *stack = calloc(1, sizeof(struct stack));
+    return stack_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* stack_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                        size_t initial_size, void *initial_values) {
+    Stack *stack = gdata_calloc(allocator, 1, sizeof(struct stack));
+    if (stack == NULL)
+        return NULL;
     *(size_t*)&stack->internal.dsize = dsize;
+    stack->internal.allocator = allocator;
     if (initial_values)
         for (size_t i = 0; i < initial_size; i++)
             stack_push(stack, (char*)initial_values + i*dsize);
@@ -14,13 +27,13 @@ void* stack_create(size_t dsize, size_t initial_size, void *initial_values) {
 
 void stack_delete(void* stack) {
     stack_clear(stack);
-    free(stack);
+    gdata_free(((Stack*)stack)->internal.allocator, stack, sizeof(struct stack));
 }
 
 // Push a new item to the head
 void stack_push(void* stack, void *data) {
     Stack *s = stack;
-    struct stack_node* node = malloc(sizeof(struct stack_node*) + s->internal.dsize);
+    struct stack_node* node = gdata_alloc(s->internal.allocator, node_size(s));
     if (node) {
         memcpy(node->data, data, s->internal.dsize);
         node->next = s->head;
@@ -36,7 +49,7 @@ void* stack_pop(void* stack) {
     s->head = node->next;
     s->size--;
     if (s->internal.pop)
-        free(s->internal.pop);
+        gdata_free(s->internal.allocator, s->internal.pop, node_size(s));
     s->internal.pop = node;
     return node->data;
 }
@@ -69,14 +82,14 @@ void* stack_copy(const void* stack) {
     const Stack *s = stack;
     char data[s->size*s->internal.dsize];
     stack_to_array(s, data);
-    return stack_create(s->internal.dsize, s->size, data);
+    return stack_create_with(s->internal.allocator, s->internal.dsize, s->size, data);
 }
 
 void stack_clear(void* stack) {
     Stack *s = stack;
     while (s->size)
         stack_pop(s);
-    free(s->internal.pop);
+    gdata_free(s->internal.allocator, s->internal.pop, node_size(s));
     s->internal.pop = NULL;
 }
 
@@ -8,21 +8,49 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdbool.h>
+#include "allocator.h"
 
+/**
+ * @brief Define a new type of Stack
+ * 
+ * Also declares the specialized `type_stack_push()`, `type_stack_pop()`
+ * and `type_stack_value()`, passing values by value
+ */
 #define STACK_TYPEDEF(type)\
 struct type ## _stack_node {\
     struct type ## _stack_node *next;\
     type data;\
 };\
-typedef struct type ## _stack {\
+struct type ## _stack {\
     size_t size;\
     struct {\
         const size_t dsize;\
         struct type ## _stack_node *pop;\
+        const struct gdata_allocator* allocator;\
     } internal;\
     struct type ## _stack_node *head;\
-} *type ## Stack
+};\
+static inline void type ## _stack_push(struct type ## _stack* s, type value) {\
+    struct type ## _stack_node* node = gdata_alloc(s->internal.allocator, sizeof(*node));\
+    if (node == NULL) return;\
+    *node = (struct type ## _stack_node){.next = s->head, .data = value};\
+    s->head = node;\
+    s->size++;\
+}\
+static inline type type ## _stack_pop(struct type ## _stack* s) {\
+    struct type ## _stack_node* node = s->head;\
+    type value = node->data;\
+    s->head = node->next;\
+    s->size--;\
+    gdata_free(s->internal.allocator, node, sizeof(*node));\
+    return value;\
+}\
+static inline type type ## _stack_value(const struct type ## _stack* s) {\
+    return s->head->data;\
+}\
+typedef struct type ## _stack *type ## Stack
 
 /**
  * @brief Creates a new Stack and attribute some values if passed
@@ -39,11 +67,11 @@ typedef struct type ## _stack {\
     stack_create(sizeof(type), sizeof(_arr)/sizeof(type), _arr);\
 })
 
-#define STACK_POP(stack) *(typeof(stack->dtype)*)stack_pop(stack)
+#define STACK_POP(stack) (*(typeof((stack)->head->data)*)stack_pop(stack))
 
-#define STACK_PUSH(stack, item) stack_push(stack, (typeof(stack->dtype)){item})
+#define STACK_PUSH(stack, item) stack_push(stack, &(typeof((stack)->head->data)){item})
 
-#define STACK_AT(stack, index) (*(typeof(stack->dtype)*)stack_at(stack, index))
+#define STACK_AT(stack, index) (*(typeof((stack)->head->data)*)stack_at(stack, index))
 
 
 struct stack_node {
@@ -56,6 +84,7 @@ typedef struct stack {
     struct {
         const size_t dsize;
         struct stack_node *pop;
+        const struct gdata_allocator* allocator;
     } internal;
     struct stack_node *head;
 } Stack;
@@ -72,6 +101,13 @@ typedef struct stack {
  */
 void* stack_create(size_t dsize, size_t initial_size, void *initial_values);
 
+/**
+ * @brief Like stack_create(), the stack and its nodes are allocated by `allocator`.
+ * Copies use it too
+ */
+void* stack_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                        size_t initial_size, void *initial_values);
+
 // Free a created stack
 void stack_delete(void* stack);
 
@@ -0,0 +1,15 @@
+/**
+ * Timing helpers for the benchmarks in tests/
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ */
+#pragma once
+#include <time.h>
+
+/// @brief Monotonic clock in seconds
+static inline double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
@@ -1,5 +1,6 @@
 #pragma once
-#include <stdlib.h>
+#include <stdbool.h>
+#include "../sort.h"
 
 typedef bool(*EqualsFunction)(void* a, void* b);
 typedef bool(*BiggerThanFunction)(void* a, void* b);
@@ -7,29 +8,12 @@ typedef bool(*SmallerThanFunction)(void* a, void* b);
 
 
 #define swap(a,b) {typeof(a) tmp = a; a = b; b = tmp;}
-// void quick_sort(void* array, )
 
-void insertion_sort(int array[], int size) {
-    for (size_t j = 1; j < size; j++) {
-        int curr = array[j];
-        int i = j - 1;
-        while (i >= 0, array[i] > curr) {
-            array[i+1] = array[i];
-            i--;
-        }
-        array[i+1] = curr;
-    }
-    
+// Kept for compatibility, see gdata_sort() in sort.h
+static inline void insertion_sort(int array[], int size) {
+    gdata_sort(array, size, sizeof(int), intcmp);
 }
 
-void bubble_sort(int *array, int size) {
-    int last_sorted_index = size;
-    while (last_sorted_index > 0) {
-        for (int i = 0; i < last_sorted_index; i++) {
-            if (array[i] > array[i+1])
-                swap(array[i], array[i+1]);
-        }
-        
-        last_sorted_index--;
-    }
-}
\ No newline at end of file
+static inline void bubble_sort(int *array, int size) {
+    gdata_sort(array, size, sizeof(int), intcmp);
+}
@@ -0,0 +1,48 @@
+/**
+ * Worker threads shared by the parallel algorithms (dict_build_bulk, gdata_parallel_sort)
+ *
+ * @author: Gabriel-AB
+ * @github: https://github.com/Gabriel-AB/
+ */
+#pragma once
+#include <pthread.h>
+#include <unistd.h>
+#include "../allocator.h"
+
+/**
+ * @brief Threads to use when `requested` ones were asked, 0 being one per
+ * online processor. Never less than 1 nor more than `max`
+ */
+static inline size_t gdata_thread_count(size_t requested, size_t max) {
+    if (requested == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        requested = processors > 0 ? (size_t)processors : 1;
+    }
+    if (requested > max)
+        requested = max;
+    return requested ? requested : 1;
+}
+
+/**
+ * @brief Run `function` on each of the `num_threads` workers, `worker_size`
+ * bytes apart, the calling thread being the first one.
+ * Workers that could not get a thread, or all of them without memory
+ * for the thread handles, run on the calling thread
+ */
+static inline void gdata_run_threads(const struct gdata_allocator* allocator, void* workers,
+                                     size_t worker_size, size_t num_threads,
+                                     void*(*function)(void*)) {
+    char* worker = workers;
+    pthread_t* threads = gdata_alloc(allocator, num_threads * sizeof(pthread_t));
+    size_t started = 1;
+    for (; threads && started < num_threads; started++) {
+        if (pthread_create(threads + started, NULL, function, worker + started*worker_size) != 0)
+            break;
+    }
+    function(worker);
+    for (size_t i = started; i < num_threads; i++)
+        function(worker + i*worker_size);
+    for (size_t i = 1; i < started; i++)
+        pthread_join(threads[i], NULL);
+    gdata_free(allocator, threads, num_threads * sizeof(pthread_t));
+}
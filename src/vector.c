@@ -1,74 +1,262 @@
+#define _GNU_SOURCE // mremap()
 #include "vector.h"
+#include "sort.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 VECTOR_TYPEDEF(uint8_t);
 
-#define VECTOR_INCREMENT 32
-#define MAX_LATERAL_SIZE 64
+// Smallest capacity allocated when growing
+#define VECTOR_MIN_ALLOC 8
 
-static void resize_right(void* vector, signed long change) {
-    uint8_tVector v = vector;
-    v->internal.alloc += change;
-    v->internal.begin = realloc(v->internal.begin, v->internal.alloc * v->internal.dsize);
-    v->at = v->internal.begin + v->internal.offset * v->internal.dsize;
+static size_t grown_capacity(const struct uint8_t_vector* v, size_t needed) {
+    size_t alloc = v->internal.alloc;
+    float factor = v->internal.growth > 1 ? v->internal.growth : VECTOR_GROWTH_FACTOR;
+    size_t grown = alloc * factor;
+    if (grown < VECTOR_MIN_ALLOC) grown = VECTOR_MIN_ALLOC;
+    return grown > needed ? grown : needed;
 }
 
-static void resize_left(void* vector, signed long change) {
-    uint8_tVector v = vector;
-    v->internal.alloc += change;
+// Elements are in the header of a small vector
+static inline bool is_inline(const struct uint8_t_vector* v) {
+    return v->internal.small && v->internal.begin == v->internal.small;
+}
+
+// Storage of vectors from vector_map_file()
+struct vector_file {
+    int fd;
+    // file offset of the elements, the header is before them
+    size_t data_offset;
+};
+
+/*
+ * Start of a file from vector_map_file(). The vector itself is kept
+ * here, so every change to its size or offset is in the file, even
+ * the ones made by the inline functions. Pointers are set when opening
+ */
+struct vector_file_header {
+    uint64_t magic;
+    uint64_t dsize;
+    uint64_t data_offset;
+    struct uint8_t_vector vector;
+};
+
+// "GDATAVEC" in a little endian file
+#define VECTOR_FILE_MAGIC 0x4345564154414447ull
+
+static void* remap_file(struct vector_file* file, void* map, size_t old_bytes, size_t bytes) {
+#ifdef __linux__
+    (void)file;
+    return mremap(map, old_bytes, bytes, MREMAP_MAYMOVE);
+#else
+    void* result = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, file->data_offset);
+    if (result != MAP_FAILED)
+        munmap(map, old_bytes);
+    return result;
+#endif
+}
+
+// Like relocate(), resizing the file and its mapping instead of the buffer
+static bool relocate_mapped(uint8_tVector v, size_t alloc, size_t offset) {
+    size_t dsize = v->internal.dsize;
+    struct vector_file* file = v->internal.file;
+    if (alloc == 0)
+        alloc = 1;
+    size_t old_bytes = v->internal.alloc * dsize;
+    size_t bytes = alloc * dsize;
+    uint8_t* begin = v->internal.begin;
+    if (bytes > old_bytes) {
+        if (ftruncate(file->fd, file->data_offset + bytes) != 0)
+            return false;
+        begin = remap_file(file, begin, old_bytes, bytes);
+        if (begin == MAP_FAILED) {
+            (void)!ftruncate(file->fd, file->data_offset + old_bytes);
+            return false;
+        }
+        memmove(begin + offset * dsize, begin + v->internal.offset * dsize, v->size * dsize);
+    } else {
+        memmove(begin + offset * dsize, v->at, v->size * dsize);
+        uint8_t* map = remap_file(file, begin, old_bytes, bytes);
+        if (map == MAP_FAILED) {
+            // still valid, just bigger than needed
+            alloc = v->internal.alloc;
+        } else {
+            begin = map;
+            // a bigger file is still valid
+            (void)!ftruncate(file->fd, file->data_offset + bytes);
+        }
+    }
+    v->internal.begin = begin;
+    v->internal.alloc = alloc;
+    v->internal.offset = offset;
+    v->at = begin + offset * dsize;
+    return true;
+}
 
-    if (change > 0) {
-        v->internal.begin = realloc(v->internal.begin, v->internal.alloc * v->internal.dsize);
-        v->at = v->internal.begin + v->internal.offset * v->internal.dsize;
-        memmove(v->at + change*(signed)v->internal.dsize, v->at, v->size * v->internal.dsize);
+/*
+ * Move the elements to a new buffer of `alloc` elements
+ * with `offset` free elements before them.
+ * Small vectors go back to their inline storage when it's enough
+ */
+static bool relocate(uint8_tVector v, size_t alloc, size_t offset) {
+    size_t dsize = v->internal.dsize;
+    const struct gdata_allocator* allocator = v->internal.allocator;
+    uint8_t* begin;
+    if (v->internal.file)
+        return relocate_mapped(v, alloc, offset);
+    if (v->internal.small && alloc <= v->internal.small_alloc) {
+        begin = v->internal.small;
+        alloc = v->internal.small_alloc;
+        memmove(begin + offset * dsize, v->at, v->size * dsize);
+        if (!is_inline(v))
+            gdata_free(allocator, v->internal.begin, v->internal.alloc * dsize);
+    } else if (alloc == 0) {
+        begin = NULL;
+        if (!is_inline(v))
+            gdata_free(allocator, v->internal.begin, v->internal.alloc * dsize);
+    } else if (offset == v->internal.offset && !is_inline(v) && v->internal.begin) {
+        begin = gdata_realloc(allocator, v->internal.begin, v->internal.alloc * dsize, alloc * dsize);
+        if (begin == NULL)
+            return false;
     } else {
-        memmove(v->at + change*(signed)v->internal.dsize, v->at, v->size * v->internal.dsize);
-        v->internal.begin = realloc(v->internal.begin, v->internal.alloc * v->internal.dsize);
+        begin = gdata_alloc(allocator, alloc * dsize);
+        if (begin == NULL)
+            return false;
+        if (v->size)
+            memcpy(begin + offset * dsize, v->at, v->size * dsize);
+        if (!is_inline(v))
+            gdata_free(allocator, v->internal.begin, v->internal.alloc * dsize);
     }
-    v->internal.offset += change;
-    v->at = v->internal.begin + v->internal.offset * v->internal.dsize;
+    v->internal.begin = begin;
+    v->internal.alloc = alloc;
+    v->internal.offset = offset;
+    v->at = begin + offset * dsize;
+    return true;
+}
+
+// Make room for `num_elements` after the end
+static bool grow_right(uint8_tVector v, size_t num_elements) {
+    size_t needed = v->internal.offset + v->size + num_elements;
+    if (needed <= v->internal.alloc)
+        return true;
+    return relocate(v, grown_capacity(v, needed), v->internal.offset);
+}
+
+// Make room for `num_elements` before the beginning, the new free space is split in both sides
+static bool grow_left(uint8_tVector v, size_t num_elements) {
+    if (num_elements <= v->internal.offset)
+        return true;
+    size_t right = v->internal.alloc - v->internal.offset - v->size;
+    size_t alloc = grown_capacity(v, v->size + num_elements + right);
+    size_t free_space = alloc - v->size - num_elements - right;
+    return relocate(v, alloc, num_elements + free_space/2);
+}
+
+// Shrink when mostly empty, keeping the elements valid
+static void check_shrink(uint8_tVector v) {
+    if (is_inline(v) || v->size >= v->internal.alloc / VECTOR_SHRINK_DIVISOR)
+        return;
+    // halved as many times as pops one by one would do
+    size_t alloc = v->internal.alloc;
+    while (alloc / 2 >= VECTOR_MIN_ALLOC && v->size < alloc / VECTOR_SHRINK_DIVISOR)
+        alloc /= 2;
+    if (alloc == v->internal.alloc)
+        return;
+    size_t offset = v->internal.offset;
+    if (offset + v->size > alloc)
+        offset = (alloc - v->size) / 2;
+    relocate(v, alloc, offset);
+}
+
+// Bytes allocated for the vector itself, small vectors keep elements in it
+static size_t header_bytes(const struct uint8_t_vector* v) {
+    if (v->internal.small == NULL)
+        return sizeof(*v);
+    // sizeof() of the small vector struct, aligned like its pointers
+    size_t size = v->internal.small - (uint8_t*)v + v->internal.small_alloc * v->internal.dsize;
+    return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
 }
 
 void* vector_create(size_t dsize, size_t initial_size, void* initial_values) {
-    uint8_tVector vector = malloc(sizeof(*vector));
+    return vector_create_with(gdata_default_allocator(), dsize, initial_size, initial_values);
+}
+
+void* vector_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                         size_t initial_size, void* initial_values) {
+    uint8_tVector vector = gdata_alloc(allocator, sizeof(*vector));
     if (vector) {
-        void* ptr = initial_size ? calloc(initial_size, dsize) : NULL;
+        void* ptr = initial_size ? gdata_calloc(allocator, initial_size, dsize) : NULL;
+        if (ptr == NULL && initial_size) {
+            gdata_free(allocator, vector, sizeof(*vector));
+            return NULL;
+        }
         *vector = (struct uint8_t_vector){
             .size = initial_size,
             .at = ptr,
             .internal.begin = ptr,
             .internal.offset = 0, 
             .internal.alloc = initial_size, 
-            .internal.dsize = dsize
+            .internal.dsize = dsize,
+            .internal.allocator = allocator
         };
-        if (initial_values) 
+        if (initial_values && initial_size)
             memcpy(vector->at, initial_values, initial_size*dsize);
     }
     return (void*)vector;
 }
 
-void vector_pushback(void* vector, size_t num_elements, void* data) {
-    uint8_tVector v = vector;
-    size_t avaliable = v->internal.alloc - v->internal.offset - v->size;
+void* vector_create_small(size_t dsize, size_t header_size, size_t small_offset,
+                          size_t initial_size, void* initial_values) {
+    return vector_create_small_with(gdata_default_allocator(), dsize, header_size, small_offset,
+                                    initial_size, initial_values);
+}
 
-    if (v->size + num_elements >= avaliable) {
-        size_t increment = (num_elements/VECTOR_INCREMENT + 1)*VECTOR_INCREMENT;
-        resize_right(v, increment);
+void* vector_create_small_with(const struct gdata_allocator* allocator, size_t dsize,
+                               size_t header_size, size_t small_offset,
+                               size_t initial_size, void* initial_values) {
+    uint8_tVector vector = gdata_alloc(allocator, header_size);
+    if (vector) {
+        uint8_t* small = (uint8_t*)vector + small_offset;
+        *vector = (struct uint8_t_vector){
+            .at = small,
+            .internal.begin = small,
+            .internal.alloc = (header_size - small_offset) / dsize,
+            .internal.dsize = dsize,
+            .internal.small = small,
+            .internal.small_alloc = (header_size - small_offset) / dsize,
+            .internal.allocator = allocator
+        };
+        vector_pushback(vector, initial_size, initial_values);
+        if (vector->size != initial_size) {
+            gdata_free(allocator, vector, header_size);
+            return NULL;
+        }
+        if (!initial_values)
+            memset(vector->at, 0, vector->size*dsize);
     }
+    return (void*)vector;
+}
+
+void vector_pushback(void* vector, size_t num_elements, void* data) {
+    uint8_tVector v = vector;
+    if (!grow_right(v, num_elements))
+        return;
     if (data) memcpy(vector_at(v, v->size), data, num_elements*v->internal.dsize);
     v->size += num_elements;
 }
 
 void vector_pushfront(void* vector, size_t num_elements, void* data) {
     uint8_tVector v = vector;
+    if (!grow_left(v, num_elements))
+        return;
 
-    if (num_elements >= v->internal.offset) {
-        size_t increment = (num_elements/VECTOR_INCREMENT + 1)*VECTOR_INCREMENT;
-        resize_left(vector, increment);
-    }
-    
     v->size += num_elements;
     v->internal.offset -= num_elements;
     v->at = v->internal.begin + v->internal.offset*v->internal.dsize;
@@ -77,31 +265,187 @@ void vector_pushfront(void* vector, size_t num_elements, void* data) {
 
 void* vector_popback(void* vector) {
     uint8_tVector v = vector;
-    size_t right = v->internal.alloc - (v->internal.offset + v->size);
-    
-    if (right > MAX_LATERAL_SIZE)
-        resize_right(vector, -VECTOR_INCREMENT);
-    
+    // before popping, so the returned element is still in the buffer
+    check_shrink(v);
     v->size--;
     return vector_at(v, v->size);
 }
 
 void* vector_popfront(void* vector) {
     uint8_tVector v = vector;
-    size_t left = v->internal.offset;
-
-    if (left > MAX_LATERAL_SIZE)
-        resize_left(vector, -VECTOR_INCREMENT);
-    
+    check_shrink(v);
     v->size--;
     v->internal.offset++;
     v->at = vector_at(v, 1);
     return v->at - v->internal.dsize;
 }
 
-void vector_delete(void* v) {
-    free(((uint8_tVector)v)->internal.begin);
-    free(v);
+void vector_reserve(void* vector, size_t capacity) {
+    uint8_tVector v = vector;
+    if (v->internal.offset + capacity > v->internal.alloc)
+        relocate(v, v->internal.offset + capacity, v->internal.offset);
+}
+
+void vector_shrink_to_fit(void* vector) {
+    uint8_tVector v = vector;
+    if (v->internal.alloc != v->size || v->internal.offset != 0)
+        relocate(v, v->size, 0);
+}
+
+void vector_set_growth_factor(void* vector, float factor) {
+    ((uint8_tVector)vector)->internal.growth = factor > 1 ? factor : VECTOR_GROWTH_FACTOR;
+}
+
+void* vector_map_file(const char* path, size_t dsize) {
+    return vector_map_file_with(gdata_default_allocator(), path, dsize);
+}
+
+// A header written by vector_map_file() for elements of `dsize` bytes, in a file of `file_size` bytes
+static bool valid_file_header(const struct vector_file_header* header, size_t file_size, size_t dsize) {
+    const struct uint8_t_vector* v = &header->vector;
+    size_t page = sysconf(_SC_PAGESIZE);
+    if (header->magic != VECTOR_FILE_MAGIC || header->dsize != dsize || dsize == 0)
+        return false;
+    if (header->data_offset < sizeof(*header) || header->data_offset % page != 0
+        || header->data_offset > file_size)
+        return false;
+    size_t capacity = (file_size - header->data_offset) / dsize;
+    return v->internal.alloc > 0 && v->internal.alloc <= capacity
+        && v->internal.offset <= v->internal.alloc
+        && v->size <= v->internal.alloc - v->internal.offset;
+}
+
+void* vector_map_file_with(const struct gdata_allocator* allocator, const char* path, size_t dsize) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return NULL;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t data_offset = (sizeof(struct vector_file_header) + page - 1) / page * page;
+    struct vector_file_header* header = MAP_FAILED;
+    struct vector_file* file = NULL;
+    struct stat st;
+    bool created = false;
+    // each vector keeps its own pointers in the header, so one at a time
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0 && fstat(fd, &st) == 0) {
+        created = st.st_size == 0;
+        if (created && ftruncate(fd, data_offset + VECTOR_MIN_ALLOC * dsize) == 0)
+            st.st_size = data_offset + VECTOR_MIN_ALLOC * dsize;
+        if ((size_t)st.st_size >= sizeof(*header))
+            header = mmap(NULL, sizeof(*header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        file = gdata_alloc(allocator, sizeof(*file));
+    }
+    if (header != MAP_FAILED && created) {
+        *header = (struct vector_file_header){
+            .dsize = dsize,
+            .data_offset = data_offset,
+            .vector.internal.alloc = VECTOR_MIN_ALLOC,
+        };
+        header->magic = VECTOR_FILE_MAGIC;
+    }
+    uint8_t* map = MAP_FAILED;
+    if (header != MAP_FAILED && file && valid_file_header(header, st.st_size, dsize)) {
+        map = mmap(NULL, header->vector.internal.alloc * dsize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, header->data_offset);
+    }
+    if (map == MAP_FAILED) {
+        if (header != MAP_FAILED)
+            munmap(header, sizeof(*header));
+        gdata_free(allocator, file, sizeof(*file));
+        close(fd);
+        return NULL;
+    }
+    *file = (struct vector_file){.fd = fd, .data_offset = header->data_offset};
+    uint8_tVector vector = &header->vector;
+    vector->at = map + vector->internal.offset * dsize;
+    vector->internal.begin = map;
+    vector->internal.dsize = dsize;
+    vector->internal.small = NULL;
+    vector->internal.small_alloc = 0;
+    vector->internal.file = file;
+    vector->internal.allocator = allocator;
+    return vector;
+}
+
+// Trim the unused capacity of the file and close it
+static void close_file(uint8_tVector v) {
+    struct vector_file* file = v->internal.file;
+    const struct gdata_allocator* allocator = v->internal.allocator;
+    if (v->internal.alloc != v->size || v->internal.offset != 0)
+        relocate_mapped(v, v->size, 0);
+    munmap(v->internal.begin, v->internal.alloc * v->internal.dsize);
+    munmap((uint8_t*)v - offsetof(struct vector_file_header, vector), sizeof(struct vector_file_header));
+    close(file->fd);
+    gdata_free(allocator, file, sizeof(*file));
+}
+
+void vector_delete(void* vector) {
+    uint8_tVector v = vector;
+    const struct gdata_allocator* allocator = v->internal.allocator;
+    // the vector is in the file header
+    if (v->internal.file) {
+        close_file(v);
+        return;
+    }
+    if (!is_inline(v))
+        gdata_free(allocator, v->internal.begin, v->internal.alloc * v->internal.dsize);
+    gdata_free(allocator, v, header_bytes(v));
+}
+
+void vector_insert_range(void* vector, size_t index, size_t num_elements, void* data) {
+    uint8_tVector v = vector;
+    size_t dsize = v->internal.dsize;
+    if (num_elements == 0)
+        return;
+    // move the smaller side
+    if (index < v->size / 2) {
+        if (!grow_left(v, num_elements))
+            return;
+        v->internal.offset -= num_elements;
+        v->at = v->internal.begin + v->internal.offset*dsize;
+        memmove(v->at, vector_at(v, num_elements), index*dsize);
+    } else {
+        if (!grow_right(v, num_elements))
+            return;
+        memmove(vector_at(v, index + num_elements), vector_at(v, index), (v->size - index)*dsize);
+    }
+    v->size += num_elements;
+    if (data) memcpy(vector_at(v, index), data, num_elements*dsize);
+}
+
+void vector_erase_range(void* vector, size_t begin, size_t end) {
+    uint8_tVector v = vector;
+    size_t dsize = v->internal.dsize;
+    size_t count = end - begin;
+    if (count == 0)
+        return;
+    // like vector_remove(), the smaller side is moved
+    if (begin < v->size - end) {
+        memmove(vector_at(v, count), v->at, begin*dsize);
+        v->at = vector_at(v, count);
+        v->internal.offset += count;
+    } else {
+        memmove(vector_at(v, begin), vector_at(v, end), (v->size - end)*dsize);
+    }
+    v->size -= count;
+    check_shrink(v);
+}
+
+size_t vector_remove_if(void* vector, bool(*pred)(void* element, void* ctx), void* ctx) {
+    uint8_tVector v = vector;
+    size_t dsize = v->internal.dsize;
+    size_t kept = 0;
+    for (size_t i = 0; i < v->size; i++) {
+        uint8_t* element = vector_at(v, i);
+        if (pred(element, ctx))
+            continue;
+        if (kept != i)
+            memcpy(vector_at(v, kept), element, dsize);
+        kept++;
+    }
+    size_t removed = v->size - kept;
+    v->size = kept;
+    check_shrink(v);
+    return removed;
 }
 
 void vector_remove(void* vector, size_t index) {
@@ -126,14 +470,14 @@ void* vector_at(const void* vector, size_t index) {
 
 void* vector_copy(void* input) {
     uint8_tVector vec = input;
-    return vector_create(vec->internal.dsize, vec->size, vec->at);
+    return vector_create_with(vec->internal.allocator, vec->internal.dsize, vec->size, vec->at);
 }
 
 void* vector_slice(const void* vector, unsigned int begin, unsigned int end) {
     const struct uint8_t_vector *vec = vector;
     size_t size = end - begin;
     void* initial_values = vec->at + begin*vec->internal.dsize;
-    return vector_create(vec->internal.dsize, size, initial_values);
+    return vector_create_with(vec->internal.allocator, vec->internal.dsize, size, initial_values);
 }
 
 bool vector_equals(const void* a, const void* b) {
@@ -142,4 +486,9 @@ bool vector_equals(const void* a, const void* b) {
         return false;
     size_t dsize = A->internal.dsize;
     return memcmp(A->at, B->at, dsize*A->size) == 0;
+}
+
+void vector_sort(void* vector, int(*cmp)(void*, void*)) {
+    uint8_tVector v = vector;
+    gdata_sort(v->at, v->size, v->internal.dsize, cmp);
 }
\ No newline at end of file
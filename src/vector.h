@@ -11,6 +11,8 @@
 #pragma once
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
+#include "allocator.h"
 
 /**
  * @brief Declare a type of vector and use `typeVector`
@@ -25,7 +27,31 @@
  *        To use any of them, define a new type using `typedef`
  */
 #define VECTOR_TYPEDEF(type)\
-typedef struct type ## _vector {\
+struct type ## _vector {\
+    VECTOR_FIELDS(type);\
+};\
+VECTOR_INLINE_FUNCTIONS(type, type ## _vector)\
+typedef struct type ## _vector *type ## Vector
+
+/**
+ * @brief Declare a vector that keeps up to N elements inside its header
+ * and use `typeSmallVectorN`. Only growing past N allocates a buffer
+ * @usage:
+ *      VECTOR_SMALL_TYPEDEF(int, 8);
+ *      intSmallVector8 v = VECTOR_SMALL_CREATE(intSmallVector8, 1, 2, 3);
+ * 
+ * @note: all vector functions accept it, copies and slices are regular vectors
+ */
+#define VECTOR_SMALL_TYPEDEF(type, N)\
+struct type ## _small_vector ## N {\
+    VECTOR_FIELDS(type);\
+    type small[N];\
+};\
+VECTOR_INLINE_FUNCTIONS(type, type ## _small_vector ## N)\
+typedef struct type ## _small_vector ## N *type ## SmallVector ## N
+
+// Fields shared by every vector, in this order
+#define VECTOR_FIELDS(type)\
     size_t size;\
     type *at;\
     struct {\
@@ -33,13 +59,66 @@ typedef struct type ## _vector {\
         size_t offset;\
         size_t alloc;\
         size_t dsize;\
-    } internal;\
-} *type ## Vector
+        type *small;\
+        size_t small_alloc;\
+        struct vector_file *file;\
+        const struct gdata_allocator *allocator;\
+        float growth;\
+    } internal
 
-// Declaring basic data vectors
-VECTOR_TYPEDEF(char);
-VECTOR_TYPEDEF(int);
-VECTOR_TYPEDEF(float);
+// Capacity is halved when less than this fraction is used. Far from the
+// growth point, so alternating push and pop does not resize back and forth
+#define VECTOR_SHRINK_DIVISOR 4
+
+// Capacity is multiplied by this factor when full (amortized O(1) pushes),
+// unless changed by vector_set_growth_factor(). Can be defined when building
+#ifndef VECTOR_GROWTH_FACTOR
+#define VECTOR_GROWTH_FACTOR 2
+#endif
+
+/**
+ * @brief Type specialized operations, declared by the typedefs as
+ * `name_at`, `name_pushback`, `name_pushfront`, `name_popback`,
+ * `name_popfront` and `name_equals`. ex: int_vector_pushback(v, 10)
+ * 
+ * Values are passed and returned by value and copied with their
+ * own type. Only growing and shrinking call the generic functions
+ */
+#define VECTOR_INLINE_FUNCTIONS(type, name)\
+static inline type* name ## _at(struct name* v, size_t index) {\
+    return v->at + index;\
+}\
+static inline void name ## _pushback(struct name* v, type value) {\
+    if (v->internal.offset + v->size < v->internal.alloc)\
+        v->at[v->size++] = value;\
+    else\
+        vector_pushback(v, 1, &value);\
+}\
+static inline void name ## _pushfront(struct name* v, type value) {\
+    if (v->internal.offset > 0) {\
+        v->internal.offset--;\
+        *--v->at = value;\
+        v->size++;\
+    } else {\
+        vector_pushfront(v, 1, &value);\
+    }\
+}\
+static inline type name ## _popback(struct name* v) {\
+    if (v->size > v->internal.alloc / VECTOR_SHRINK_DIVISOR)\
+        return v->at[--v->size];\
+    return *(type*)vector_popback(v);\
+}\
+static inline type name ## _popfront(struct name* v) {\
+    if (v->size > v->internal.alloc / VECTOR_SHRINK_DIVISOR) {\
+        v->size--;\
+        v->internal.offset++;\
+        return *v->at++;\
+    }\
+    return *(type*)vector_popfront(v);\
+}\
+static inline bool name ## _equals(const struct name* a, const struct name* b) {\
+    return a->size == b->size && memcmp(a->at, b->at, a->size * sizeof(type)) == 0;\
+}
 
 // ===== MACROS ===== //
 
@@ -55,6 +134,19 @@ VECTOR_TYPEDEF(float);
     vector_create(sizeof(type), sizeof(_vec)/sizeof(*_vec), _vec);\
 })
 
+/**
+ * @brief Creates a new small vector with values if passed
+ * @note: You must call `vector_delete()` later
+ * 
+ * @param vector_type: a type declared by VECTOR_SMALL_TYPEDEF(). ex: intSmallVector8
+ * @param __VA_ARGS__: values to initialize vector
+ */
+#define VECTOR_SMALL_CREATE(vector_type, ...) ({\
+    typeof(*((vector_type)0)->at) _vec[] = {__VA_ARGS__};\
+    (vector_type)vector_create_small(sizeof(*_vec), sizeof(*(vector_type)0),\
+        offsetof(typeof(*(vector_type)0), small), sizeof(_vec)/sizeof(*_vec), _vec);\
+})
+
 /**
  * @brief Creates a new vector with given size.
  * All elements are set to zero
@@ -84,6 +176,16 @@ VECTOR_TYPEDEF(float);
     vector_pushfront(vector, sizeof(_vec)/sizeof(*_vec), _vec);\
 })
 
+/**
+ * @brief Insert one or more values before index
+ * @param vector: any type of vector
+ * @param __VA_ARGS__: values to insert, the type inside list or literal
+ */
+#define VECTOR_INSERT(vector, index, ...) ({\
+    typeof(*vector->at) _vec[] = {__VA_ARGS__};\
+    vector_insert_range(vector, index, sizeof(_vec)/sizeof(*_vec), _vec);\
+})
+
 /**
  * @brief Get the last element and remove it from vector
  * @return value
@@ -108,6 +210,32 @@ VECTOR_TYPEDEF(float);
  */
 void* vector_create(size_t dsize, size_t initial_size, void* initial_values);
 
+/**
+ * @brief Like vector_create(), the vector and its buffer are allocated by `allocator`.
+ * Copies and slices use it too
+ */
+void* vector_create_with(const struct gdata_allocator* allocator, size_t dsize,
+                         size_t initial_size, void* initial_values);
+
+/**
+ * @brief Create a vector with inline storage in a single allocation
+ * 
+ * @param dsize: size of each element in bytes
+ * @param header_size: size of the whole vector struct, inline elements included
+ * @param small_offset: where the inline elements start in the struct
+ * @param initial_size: initial size of the list. (0 is valid)
+ * @param initial_values: pointer to data that will be pushed first. (0 is valid)
+ * 
+ * @see VECTOR_SMALL_CREATE() macro
+ */
+void* vector_create_small(size_t dsize, size_t header_size, size_t small_offset,
+                          size_t initial_size, void* initial_values);
+
+/// @brief Like vector_create_small(), the header and any spilled buffer are allocated by `allocator`
+void* vector_create_small_with(const struct gdata_allocator* allocator, size_t dsize,
+                               size_t header_size, size_t small_offset,
+                               size_t initial_size, void* initial_values);
+
 /**
  * @brief Push data to vector's end.
  * 
@@ -152,15 +280,79 @@ void* vector_popback(void* vector);
  */
 void* vector_popfront(void* vector);
 
+/**
+ * @brief Make room for `capacity` elements,
+ * pushing back up to that size does not reallocate
+ */
+void vector_reserve(void* vector, size_t capacity);
+
+/**
+ * @brief Release the memory not used by elements
+ */
+void vector_shrink_to_fit(void* vector);
+
+/**
+ * @brief Change the factor multiplying the capacity when the vector is full.
+ * Smaller factors waste less memory, bigger ones copy the elements less often
+ * 
+ * @param factor: must be > 1, otherwise VECTOR_GROWTH_FACTOR is used
+ */
+void vector_set_growth_factor(void* vector, float factor);
+
 // Remove element at given index
 void vector_remove(void* vector, size_t index);
 
+/**
+ * @brief Insert data before index, moving the elements of the smaller side
+ * 
+ * @param index: position of the first inserted element, in [0, size]
+ * @param num_elements: number of elements in data
+ * @param data: array with values to be inserted (values will be copied)
+ * 
+ * @see VECTOR_INSERT() macro
+ */
+void vector_insert_range(void* vector, size_t index, size_t num_elements, void* data);
+
+/**
+ * @brief Remove elements in [begin, end), moving the elements of the smaller side
+ */
+void vector_erase_range(void* vector, size_t begin, size_t end);
+
+/**
+ * @brief Remove all elements where pred(element, ctx) is true,
+ * keeping the order of the others. Single pass
+ * 
+ * @return number of removed elements
+ */
+size_t vector_remove_if(void* vector, bool(*pred)(void* element, void* ctx), void* ctx);
+
 // Get a pointer to the given index of a vector.
 void* vector_at(const void* vector, size_t index);
 
 // Destructor
 void vector_delete(void* vector);
 
+/**
+ * @brief Open a vector stored in a file, created if it does not exist or is empty.
+ * The elements are not loaded: `at` points to a shared mapping of the file,
+ * which grows and shrinks with the vector
+ * 
+ * The file starts with a header page holding the vector itself, so its
+ * size is in the file after every change, even without vector_delete()
+ * 
+ * @param dsize: size of each element in bytes, the same the file was created with
+ * @return NULL if the file can not be opened or mapped, was not created by
+ * this function with the same `dsize`, or is open by another vector
+ * @note vector_delete() trims the unused capacity from the file
+ */
+void* vector_map_file(const char* path, size_t dsize);
+
+/**
+ * @brief Like vector_map_file(), the header is allocated by `allocator`,
+ * as are copies and slices. The elements stay in the file
+ */
+void* vector_map_file_with(const struct gdata_allocator* allocator, const char* path, size_t dsize);
+
 // Obs: the return is a new vector, then you may free it later
 void* vector_copy(void* input);
 
@@ -169,3 +361,16 @@ void* vector_slice(const void* vector, unsigned int begin, unsigned int end);
 
 /// Test if two vectors are equal
 bool vector_equals(const void* a, const void* b);
+
+/**
+ * @brief Sort elements in ascending order
+ * 
+ * @param cmp: comparator, like the ones given to heap_create(). ex: intcmp
+ * @see gdata_sort()
+ */
+void vector_sort(void* vector, int(*cmp)(void*, void*));
+
+// Declaring basic data vectors, after the functions their fast paths call
+VECTOR_TYPEDEF(char);
+VECTOR_TYPEDEF(int);
+VECTOR_TYPEDEF(float);
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "allocator.h"
+#include "array.h"
+#include "vector.h"
+#include "list.h"
+#include "stack.h"
+#include "heap.h"
+#include "deque.h"
+#include "segvector.h"
+#include "dict.h"
+#include "cdict.h"
+#include "cache.h"
+#include "utils/bench.h"
+
+STACK_TYPEDEF(int);
+HEAP_TYPEDEF(int);
+
+/*
+ * Keeps the requested size before each block, so every size hint given
+ * to free() and realloc() is checked. Counters are atomic, for the
+ * containers allocating from many threads
+ */
+struct tracker {
+    size_t live_blocks;
+    size_t live_bytes;
+    size_t allocations;
+};
+
+static void* track_alloc(void* ctx, size_t size) {
+    struct tracker* t = ctx;
+    size_t* block = malloc(sizeof(size_t) * 2 + size);
+    if (block == NULL)
+        return NULL;
+    block[0] = size;
+    __atomic_add_fetch(&t->live_blocks, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->allocations, 1, __ATOMIC_RELAXED);
+    return block + 2;
+}
+
+static void track_free(void* ctx, void* ptr, size_t size) {
+    struct tracker* t = ctx;
+    size_t* block = (size_t*)ptr - 2;
+    assert(block[0] == size);
+    __atomic_sub_fetch(&t->live_blocks, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&t->live_bytes, size, __ATOMIC_RELAXED);
+    free(block);
+}
+
+static void* track_realloc(void* ctx, void* ptr, size_t old_size, size_t size) {
+    struct tracker* t = ctx;
+    size_t* block = ptr ? (size_t*)ptr - 2 : NULL;
+    assert(block == NULL || block[0] == old_size);
+    block = realloc(block, sizeof(size_t) * 2 + size);
+    if (block == NULL)
+        return NULL;
+    if (ptr == NULL) __atomic_add_fetch(&t->live_blocks, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->live_bytes, size - old_size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->allocations, 1, __ATOMIC_RELAXED);
+    block[0] = size;
+    return block + 2;
+}
+
+#define TRACKER(name)\
+    struct tracker name ## _state = {0};\
+    struct gdata_allocator name = {track_alloc, track_realloc, track_free, &name ## _state}
+
+VECTOR_SMALL_TYPEDEF(int, 4);
+
+void test_allocator_arrays() {
+    TRACKER(tracker);
+    intArray array = array_create_with(&tracker, sizeof(int), 10, NULL);
+    array->at[9] = 9;
+    array = array_resize(array, 1000);
+    assert(array->size == 1000 && array->at[9] == 9);
+    intArray slice = array_slice(array, 0, 10);
+    assert(slice->internal.allocator == &tracker);
+    array_delete(slice);
+    array_delete(array);
+
+    intVector v = vector_create_with(&tracker, sizeof(int), 3, NULL);
+    for (int i = 0; i < 10000; i++)
+        VECTOR_PUSHFRONT(v, i);
+    intVector copy = vector_copy(v);
+    while (v->size > 10)
+        vector_popback(v);
+    vector_shrink_to_fit(v);
+    vector_erase_range(v, 0, v->size);
+    vector_shrink_to_fit(v);
+    vector_delete(v);
+    vector_delete(copy);
+
+    intSmallVector4 small = vector_create_small_with(&tracker, sizeof(int), sizeof(*small),
+        offsetof(struct int_small_vector4, small), 3, (int[]){1, 2, 3});
+    VECTOR_PUSHBACK(small, 4, 5, 6);
+    vector_shrink_to_fit(small);
+    vector_delete(small);
+
+    const char* path = "test_allocator_map.bin";
+    intVector mapped = vector_map_file_with(&tracker, path, sizeof(int));
+    VECTOR_PUSHBACK(mapped, 1, 2, 3);
+    copy = vector_copy(mapped);
+    assert(copy->internal.allocator == &tracker);
+    vector_delete(copy);
+    vector_delete(mapped);
+    remove(path);
+    assert(tracker_state.allocations > 10);
+    assert(tracker_state.live_blocks == 0 && tracker_state.live_bytes == 0);
+}
+
+void test_allocator_linked() {
+    TRACKER(tracker);
+    intList list = list_create_with(&tracker, sizeof(int), 3, (int[]){1, 2, 3});
+    int_list_pushback(list, 4);
+    LIST_PUSHFRONT(list, 0);
+    assert(int_list_popfront(list) == 0);
+    assert(LIST_POPBACK(list) == 4);
+    intList copy = list_copy(list);
+    assert(list_equals(list, copy));
+    list_delete(copy);
+    list_delete(list);
+
+    intStack stack = stack_create_with(&tracker, sizeof(int), 2, (int[]){1, 2});
+    int_stack_push(stack, 3);
+    STACK_PUSH(stack, 4);
+    assert(int_stack_pop(stack) == 4);
+    assert(STACK_POP(stack) == 3);
+    intStack stack_copied = stack_copy(stack);
+    assert(stack_equals(stack, stack_copied));
+    stack_delete(stack_copied);
+    stack_delete(stack);
+    assert(tracker_state.live_blocks == 0 && tracker_state.live_bytes == 0);
+}
+
+void test_allocator_buffers() {
+    TRACKER(tracker);
+    intHeap heap = heap_create_with(&tracker, sizeof(int), 100, intcmp, MIN_HEAP);
+    for (int i = 100; i > 0; i--)
+        int_heap_push(heap, i);
+    assert(int_heap_pop(heap) == 1);
+    heap_delete(heap);
+
+    intDeque deque = deque_create_with(&tracker, sizeof(int), 0, NULL);
+    for (int i = 0; i < 1000; i++)
+        DEQUE_PUSHFRONT(deque, i);
+    deque_delete(deque);
+
+    intSegVector segvector = segvector_create_with(&tracker, sizeof(int), 5, NULL);
+    for (int i = 0; i < 1000; i++)
+        SEGVECTOR_PUSHBACK(segvector, i);
+    while (segvector->size > 20)
+        segvector_popback(segvector);
+    segvector_shrink(segvector);
+    segvector_delete(segvector);
+    assert(tracker_state.live_blocks == 0 && tracker_state.live_bytes == 0);
+}
+
+void test_allocator_dicts() {
+    TRACKER(tracker);
+    char key[64];
+    Dict dict = dict_create_with(&tracker, 0);
+    Dict ordered = dict_create_ordered_with(&tracker, 0);
+    dict_enable_filter(dict, 10);
+    for (size_t i = 0; i < 5000; i++) {
+        // long keys go to the arenas
+        snprintf(key, sizeof(key), "a long key that is not stored inline %zu", i);
+        dict_setref(dict, key, (void*)i);
+        dict_setref(ordered, key, (void*)i);
+        if (i % 3 == 0) dict_remove(ordered, key);
+    }
+    assert(dict_keys(dict)[0] && dict_keys(ordered)[0]);
+    for (size_t i = 0; i < 4000; i++) {
+        snprintf(key, sizeof(key), "a long key that is not stored inline %zu", i);
+        dict_remove(dict, key);
+    }
+    assert(dict_keys(dict)[0]);
+    Dict strings = dict_create_with(&tracker, 0);
+    dict_setref(strings, "a key long enough for the arena", "value");
+    assert(dict_save(strings, "test_allocator_dict.bin", NULL));
+    remove("test_allocator_dict.bin");
+    dict_delete(strings);
+    FrozenDict frozen = dict_freeze(ordered);
+    assert(frozen && frozen_dict_get(frozen, "a long key that is not stored inline 1") == (void*)1);
+    frozen_dict_delete(frozen);
+    dict_delete(ordered);
+    dict_delete(dict);
+
+    static char names[100000][16];
+    const char* keys[100000];
+    for (size_t i = 0; i < 100000; i++) {
+        snprintf(names[i], sizeof(names[i]), "bulk %zu", i);
+        keys[i] = names[i];
+    }
+    Dict bulk = dict_build_bulk_with(&tracker, keys, (void**)keys, 100000, 4, NULL);
+    assert(dict_size(bulk) == 100000 && dict_get(bulk, "bulk 1234") == names[1234]);
+    dict_delete(bulk);
+
+    CDict concurrent = cdict_create_with(&tracker, 4, 0);
+    for (size_t i = 0; i < 10000; i++)
+        cdict_set(concurrent, keys[i], names[i], NULL);
+    for (size_t i = 0; i < 10000; i += 2)
+        cdict_remove(concurrent, keys[i]);
+    assert(cdict_size(concurrent) == 5000);
+    cdict_delete(concurrent);
+
+    int_floatDict typed = tdict_create_with(&tracker, sizeof(int), sizeof(float),
+        offsetof(struct int_float_dict_entry, value), sizeof(struct int_float_dict_entry), 0);
+    for (int i = 0; i < 1000; i++)
+        TDICT_SET(typed, i, i * 0.5f);
+    tdict_delete(typed);
+
+    Cache cache = cache_create_with(&tracker, 10, 0);
+    for (size_t i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key %zu", i);
+        cache_put(cache, key, NULL, 1, 0, NULL);
+    }
+    assert(cache_size(cache) == 10);
+    cache_delete(cache);
+    assert(tracker_state.live_blocks == 0 && tracker_state.live_bytes == 0);
+}
+
+void test_allocator_default() {
+    TRACKER(tracker);
+    assert(gdata_default_allocator() == &gdata_libc_allocator);
+    gdata_set_default_allocator(&tracker);
+    intVector v = VECTOR_CREATE(int, 1, 2, 3);
+    intArray array = ARRAY_CREATE(int, {1, 2, 3});
+    Dict dict = dict_create(0);
+    gdata_set_default_allocator(NULL);
+    assert(gdata_default_allocator() == &gdata_libc_allocator);
+
+    // containers keep the allocator they were created with
+    assert(v->internal.allocator == &tracker);
+    VECTOR_PUSHBACK(v, 4, 5, 6, 7, 8, 9);
+    intVector copy = vector_copy(v);
+    assert(copy->internal.allocator == &tracker);
+    assert(tracker_state.live_blocks == 7);
+    vector_delete(copy);
+    vector_delete(v);
+    array_delete(array);
+    dict_delete(dict);
+    assert(tracker_state.live_blocks == 0 && tracker_state.live_bytes == 0);
+}
+
+/*
+ * Free list of fixed size blocks, the kind of allocator worth giving
+ * to a container with many small nodes
+ */
+struct pool {
+    void* free_list;
+    size_t block_size;
+    char* chunk;
+    size_t chunk_left;
+    void* chunks;
+};
+
+static void* pool_alloc(void* ctx, size_t size) {
+    struct pool* p = ctx;
+    if (size > p->block_size)
+        return malloc(size);
+    void* block = p->free_list;
+    if (block) {
+        p->free_list = *(void**)block;
+        return block;
+    }
+    if (p->chunk_left == 0) {
+        size_t count = 4096;
+        void** chunk = malloc(sizeof(void*) + count * p->block_size);
+        if (chunk == NULL)
+            return NULL;
+        *chunk = p->chunks;
+        p->chunks = chunk;
+        p->chunk = (char*)(chunk + 1);
+        p->chunk_left = count;
+    }
+    block = p->chunk;
+    p->chunk += p->block_size;
+    p->chunk_left--;
+    return block;
+}
+
+static void pool_free(void* ctx, void* ptr, size_t size) {
+    struct pool* p = ctx;
+    if (size > p->block_size) {
+        free(ptr);
+        return;
+    }
+    *(void**)ptr = p->free_list;
+    p->free_list = ptr;
+}
+
+static void pool_destroy(struct pool* p) {
+    while (p->chunks) {
+        void* next = *(void**)p->chunks;
+        free(p->chunks);
+        p->chunks = next;
+    }
+}
+
+static double list_churn(const struct gdata_allocator* allocator) {
+    intList list = list_create_with(allocator, sizeof(int), 0, NULL);
+    double start = now();
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 100000; i++)
+            int_list_pushback(list, i);
+        while (list->size)
+            int_list_popfront(list);
+    }
+    double elapsed = now() - start;
+    list_delete(list);
+    return elapsed;
+}
+
+void test_allocator_pool() {
+    struct pool state = {.block_size = 32};
+    struct gdata_allocator pool = {pool_alloc, NULL, pool_free, &state};
+    printf("list nodes with libc: %.3fs\n", list_churn(&gdata_libc_allocator));
+    printf("list nodes with pool: %.3fs\n", list_churn(&pool));
+    pool_destroy(&state);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_allocator_arrays,
+        test_allocator_linked,
+        test_allocator_buffers,
+        test_allocator_dicts,
+        test_allocator_default,
+        test_allocator_pool
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 #include "array.h"
 
 #define TEST_VALUE {1,2,3,4}
@@ -70,6 +71,64 @@ void test_array_equals() {
     free(b);
 }
 
+void test_array_typed() {
+    intArray a = array_create(sizeof(int), 4, (int[])TEST_VALUE);
+    intArray b = array_create(sizeof(int), 4, (int[])TEST_VALUE);
+    assert(int_array_equals(a, b));
+    *int_array_at(b, 3) = 5;
+    assert(!int_array_equals(a, b));
+    assert(*int_array_at(a, 3) == 4);
+    free(a);
+    free(b);
+}
+
+void test_array_map_file() {
+    const char* path = "test_array_map.bin";
+    float values[3000];
+    for (int i = 0; i < 3000; i++)
+        values[i] = i * 0.5f;
+    FILE* file = fopen(path, "wb");
+    fwrite(values, sizeof(float), 3000, file);
+    fputc(0, file); // not a whole element
+    fclose(file);
+
+    floatArray array = ARRAY_MAP_FILE(float, path);
+    assert(array && array->size == 3000 && array->internal.dsize == sizeof(float));
+    assert(memcmp(array->at, values, sizeof(values)) == 0);
+    array->at[10] = -1.0f;
+    array_unmap(array);
+
+    // changes are in the file
+    array = ARRAY_MAP_FILE(float, path);
+    assert(array->at[10] == -1.0f && array->at[2999] == 2999 * 0.5f);
+    array_unmap(array);
+    remove(path);
+    assert(ARRAY_MAP_FILE(float, path) == NULL);
+}
+
+void test_array_map_anonymous() {
+    size_t n = 3 << 20;
+    floatArray array = ARRAY_MAP_ANONYMOUS(float, n);
+    assert(array && array->size == n);
+    // large arrays start at a huge page
+    assert(((size_t)array->at & ((2 << 20) - 1)) == 0);
+    for (size_t i = 0; i < n; i++)
+        assert(array->at[i] == 0);
+    for (size_t i = 0; i < n; i++)
+        array->at[i] = i;
+    assert(array->at[n - 1] == n - 1);
+    array_unmap(array);
+
+    intArray small = ARRAY_MAP_ANONYMOUS(int, 10);
+    small->at[9] = 9;
+    intArray copy = array_slice(small, 0, 10);
+    assert(array_equals(small, copy));
+    free(copy);
+    // mapped arrays can not be reallocated
+    assert(array_resize(small, 20) == NULL && small->size == 10);
+    array_unmap(small);
+}
+
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <id>\n", argv[0]);
@@ -80,7 +139,10 @@ int main(int argc, char const *argv[]) {
         test_array_resize,
         test_array_join,
         test_array_equals,
-        test_array_slice
+        test_array_slice,
+        test_array_typed,
+        test_array_map_file,
+        test_array_map_anonymous
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cache.h"
+#include "utils.h"
+
+void test_cache_create() {
+    Cache c = cache_create(10, 0);
+    assert(c != NULL);
+    assert(cache_size(c) == 0);
+    assert(cache_get(c, "a") == NULL);
+    cache_delete(c);
+}
+
+void test_cache_lru() {
+    Cache c = cache_create(3, 0);
+    cache_put(c, "a", newobj(int, 1), 1, 0, free);
+    cache_put(c, "b", newobj(int, 2), 1, 0, free);
+    cache_put(c, "c", newobj(int, 3), 1, 0, free);
+    assert(*(int*)cache_get(c, "a") == 1);
+
+    // "b" is the least recently used
+    cache_put(c, "d", newobj(int, 4), 1, 0, free);
+    assert(cache_size(c) == 3);
+    assert(cache_get(c, "b") == NULL);
+    assert(*(int*)cache_get(c, "a") == 1);
+    assert(*(int*)cache_get(c, "c") == 3);
+    assert(*(int*)cache_get(c, "d") == 4);
+
+    // replacing frees the old value and refreshes the entry
+    cache_put(c, "a", newobj(int, 10), 1, 0, free);
+    cache_put(c, "e", newobj(int, 5), 1, 0, free);
+    assert(cache_get(c, "c") == NULL);
+    assert(*(int*)cache_get(c, "a") == 10);
+
+    cache_remove(c, "a");
+    assert(cache_size(c) == 2);
+    assert(cache_get(c, "a") == NULL);
+
+    char key[16];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%d", i);
+        cache_put(c, key, newobj(int, i), 1, 0, free);
+    }
+    assert(cache_size(c) == 3);
+    assert(*(int*)cache_get(c, "997") == 997);
+    cache_delete(c);
+}
+
+void test_cache_bytes() {
+    Cache c = cache_create(0, 100);
+    cache_put(c, "a", "a", 40, 0, NULL);
+    cache_put(c, "b", "b", 40, 0, NULL);
+    assert(cache_bytes(c) == 80);
+    cache_put(c, "c", "c", 40, 0, NULL);
+    assert(cache_bytes(c) == 80);
+    assert(cache_get(c, "a") == NULL);
+
+    // an entry bigger than the capacity evicts everything else
+    cache_put(c, "big", "big", 500, 0, NULL);
+    assert(cache_size(c) == 1);
+    assert(cache_bytes(c) == 500);
+    assert(strcmp(cache_get(c, "big"), "big") == 0);
+    cache_put(c, "big", "small", 10, 0, NULL);
+    assert(cache_bytes(c) == 10);
+    cache_delete(c);
+}
+
+void test_cache_ttl() {
+    Cache c = cache_create(0, 0);
+    cache_put(c, "short", newobj(int, 1), 1, 20, free);
+    cache_put(c, "long", newobj(int, 2), 1, 10000, free);
+    cache_put(c, "forever", newobj(int, 3), 1, 0, free);
+    assert(*(int*)cache_get(c, "short") == 1);
+
+    nanosleep(&(struct timespec){.tv_nsec = 30000000}, NULL);
+    assert(cache_get(c, "short") == NULL);
+    assert(cache_size(c) == 2);
+    assert(*(int*)cache_get(c, "long") == 2);
+    assert(*(int*)cache_get(c, "forever") == 3);
+    cache_delete(c);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_cache_create,
+        test_cache_lru,
+        test_cache_bytes,
+        test_cache_ttl
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
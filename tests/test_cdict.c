@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "cdict.h"
+#include "utils.h"
+#include "utils/bench.h"
+
+#define STRESS_KEYS 1000
+#define STRESS_OPS 200000
+
+void test_cdict_create() {
+    CDict d = cdict_create(4, 100);
+    assert(d != NULL);
+    assert(cdict_size(d) == 0);
+    cdict_delete(d);
+}
+
+void test_cdict_set_get() {
+    CDict d = cdict_create(0, 0);
+    char key[32];
+    for (int i = 0; i < 5000; i++) {
+        sprintf(key, "key number %d", i);
+        cdict_set(d, key, newobj(int, i), free);
+    }
+    assert(cdict_size(d) == 5000);
+
+    cdict_set(d, "key number 10", newobj(int, -10), free);
+    assert(*(int*)cdict_get(d, "key number 10") == -10);
+    assert(cdict_size(d) == 5000);
+
+    for (int i = 0; i < 5000; i += 2) {
+        sprintf(key, "key number %d", i);
+        cdict_remove(d, key);
+    }
+    assert(cdict_size(d) == 2500);
+
+    for (int i = 1; i < 5000; i += 2) {
+        sprintf(key, "key number %d", i);
+        int* value = cdict_get(d, key);
+        assert(value && *value == i);
+        sprintf(key, "key number %d", i - 1);
+        assert(cdict_get(d, key) == NULL);
+    }
+    cdict_delete(d);
+}
+
+struct stress_args {
+    CDict dict;
+    unsigned seed;
+    bool writer;
+};
+
+// values always hold the number in their key, reading a freed value is caught by ASAN
+static void* stress_thread(void* arg) {
+    struct stress_args* args = arg;
+    char key[16];
+    for (int i = 0; i < STRESS_OPS; i++) {
+        int n = rand_r(&args->seed) % STRESS_KEYS;
+        sprintf(key, "%d", n);
+        int op = rand_r(&args->seed) % 4;
+
+        if (args->writer && op == 0) {
+            cdict_set(args->dict, key, newobj(int, n), free);
+        } else if (args->writer && op == 1) {
+            cdict_remove(args->dict, key);
+        } else {
+            cdict_read_begin();
+            int* value = cdict_get(args->dict, key);
+            assert(value == NULL || *value == n);
+            cdict_read_end();
+        }
+    }
+    return NULL;
+}
+
+void test_cdict_stress() {
+    CDict d = cdict_create(4, 0);
+    pthread_t threads[8];
+    struct stress_args args[8];
+
+    for (int i = 0; i < 8; i++) {
+        args[i] = (struct stress_args){d, i + 1, i % 2 == 0};
+        pthread_create(threads + i, NULL, stress_thread, args + i);
+    }
+    for (int i = 0; i < 8; i++)
+        pthread_join(threads[i], NULL);
+
+    size_t count = 0;
+    char key[16];
+    for (int n = 0; n < STRESS_KEYS; n++) {
+        sprintf(key, "%d", n);
+        int* value = cdict_get(d, key);
+        assert(value == NULL || *value == n);
+        count += value != NULL;
+    }
+    assert(count == cdict_size(d));
+    cdict_delete(d);
+}
+
+static CDict parents;
+
+// removing "parent N" also removes "child N", from the destructor
+static void remove_child(void* value) {
+    char key[32];
+    if (parents) {
+        sprintf(key, "child %d", *(int*)value);
+        cdict_remove(parents, key);
+    }
+    free(value);
+}
+
+void test_cdict_reentrant() {
+    CDict d = parents = cdict_create(1, 0);
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "parent %d", i);
+        cdict_set(d, key, newobj(int, i), remove_child);
+        sprintf(key, "child %d", i);
+        cdict_set(d, key, newobj(int, i), free);
+    }
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "parent %d", i);
+        cdict_remove(d, key);
+    }
+    // most destructors already ran, while removing the next parents
+    assert(cdict_size(d) < 500);
+    parents = NULL;
+    cdict_delete(d);
+}
+
+struct throughput_args {
+    CDict dict;
+    unsigned seed;
+    size_t ops;
+};
+
+static char throughput_keys[100000][16];
+
+// 90% lookups, 10% updates
+static void* throughput_thread(void* arg) {
+    struct throughput_args* args = arg;
+    for (size_t i = 0; i < args->ops; i++) {
+        const char* key = throughput_keys[rand_r(&args->seed) % 100000];
+        if (i % 10 == 0)
+            cdict_set(args->dict, key, (void*)key, NULL);
+        else
+            assert(cdict_get(args->dict, key) == key);
+    }
+    return NULL;
+}
+
+void test_cdict_throughput() {
+    CDict d = cdict_create(0, 100000);
+    for (int i = 0; i < 100000; i++) {
+        sprintf(throughput_keys[i], "key%d", i);
+        cdict_set(d, throughput_keys[i], throughput_keys[i], NULL);
+    }
+
+    const size_t ops = 1000000;
+    for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+        pthread_t threads[8];
+        struct throughput_args args[8];
+        double start = now();
+        for (int i = 0; i < num_threads; i++) {
+            args[i] = (struct throughput_args){d, i + 1, ops / num_threads};
+            pthread_create(threads + i, NULL, throughput_thread, args + i);
+        }
+        for (int i = 0; i < num_threads; i++)
+            pthread_join(threads[i], NULL);
+        printf("threads: %d, %.2f Mops/s\n", num_threads, ops / (now() - start) / 1e6);
+    }
+    cdict_delete(d);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_cdict_create,
+        test_cdict_set_get,
+        test_cdict_stress,
+        test_cdict_throughput,
+        test_cdict_reentrant
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
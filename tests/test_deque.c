@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "deque.h"
+
+void test_deque_create() {
+    intDeque d = DEQUE_CREATE(int, 1, 2, 3, 4);
+    assert(d->size == 4);
+    assert(d->internal.dsize == sizeof(int));
+    for (int i = 0; i < 4; i++)
+        assert(DEQUE_AT(d, i) == i + 1);
+    deque_delete(d);
+
+    d = deque_create(sizeof(int), 3, NULL);
+    assert(d->size == 3 && DEQUE_AT(d, 2) == 0);
+    deque_delete(d);
+}
+
+void test_deque_queue() {
+    intDeque d = deque_create(sizeof(int), 0, NULL);
+    // the buffer wraps around many times without growing
+    for (int i = 0; i < 5; i++)
+        DEQUE_PUSHBACK(d, i);
+    size_t alloc = d->internal.alloc;
+    for (int i = 5; i < 100000; i++) {
+        DEQUE_PUSHBACK(d, i);
+        assert(DEQUE_POPFRONT(d) == i - 5);
+    }
+    assert(d->internal.alloc == alloc);
+    assert(d->size == 5);
+    deque_delete(d);
+}
+
+void test_deque_pushfront() {
+    intDeque d = DEQUE_CREATE(int, 5, 6);
+    DEQUE_PUSHFRONT(d, 3, 4);
+    DEQUE_PUSHFRONT(d, 1, 2);
+    DEQUE_PUSHBACK(d, 7, 8);
+    assert(d->size == 8);
+    for (int i = 0; i < 8; i++)
+        assert(DEQUE_AT(d, i) == i + 1);
+
+    assert(DEQUE_POPBACK(d) == 8);
+    assert(DEQUE_POPFRONT(d) == 1);
+    DEQUE_AT(d, 0) = 20;
+    assert(*(int*)deque_at(d, 0) == 20);
+    deque_delete(d);
+}
+
+void test_deque_growth() {
+    intDeque d = deque_create(sizeof(int), 0, NULL);
+    // grows while wrapped around the buffer end
+    for (int i = 0; i < 10000; i++) {
+        DEQUE_PUSHFRONT(d, -i - 1);
+        DEQUE_PUSHBACK(d, i);
+    }
+    assert(d->size == 20000);
+    for (int i = 0; i < 20000; i++)
+        assert(DEQUE_AT(d, i) == i - 10000);
+
+    int values[1000];
+    for (int i = 0; i < 1000; i++)
+        values[i] = i;
+    deque_pushfront(d, 1000, values);
+    deque_pushback(d, 1000, values);
+    assert(DEQUE_AT(d, 0) == 0 && DEQUE_AT(d, 999) == 999 && DEQUE_AT(d, 1000) == -10000);
+    assert(DEQUE_AT(d, 21000) == 0 && DEQUE_AT(d, 21999) == 999);
+
+    deque_clear(d);
+    assert(d->size == 0);
+    deque_reserve(d, 100000);
+    assert(d->internal.alloc >= 100000);
+    deque_delete(d);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_deque_create,
+        test_deque_queue,
+        test_deque_pushfront,
+        test_deque_growth
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
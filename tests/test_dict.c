@@ -3,28 +3,12 @@
 #include <string.h>
 #include <assert.h>
 #include "dict.h"
-
-struct dict_pair {
-    struct dict_pair* next;
-    void(*del)(void*);
-    char key[32];
-    void* value;
-};
-
-struct dict {
-    struct dict_pair** table;
-    size_t table_size;
-    size_t num_elements;
-    const char** keys;
-    bool update_keys;
-};
-
+#include "utils.h"
 
 void test_dict_creation_and_deletion() {
     Dict d = dict_create(10);
     assert(d != NULL);
-    assert(d->num_elements == 0);
-    assert(d->table_size == 10);
+    assert(dict_size(d) == 0);
     dict_delete(d);
 }
 
@@ -44,7 +28,7 @@ void test_dict_set_adding() {
     dict_set(d, "str", (void*)str, fake_free_str);
     dict_set(d, "int", &a, fake_free_int);
     dict_set(d, "int2", (int[]){10}, fake_free_int);
-    assert(d->num_elements == 3);
+    assert(dict_size(d) == 3);
     dict_delete(d);
 }
 
@@ -74,7 +58,7 @@ void test_dict_set_updating() {
     assert(&b == (int*)dict_get(d, "int"));
     assert(5 == *(int*)dict_get(d, "int"));
 
-    assert(d->num_elements == 1);
+    assert(dict_size(d) == 1);
     dict_delete(d);
 }
 
@@ -93,7 +77,7 @@ void test_dict_get() {
     out = *(int*)dict_get(d, "2");
     assert(in == out);
 
-    assert(d->num_elements == 2);
+    assert(dict_size(d) == 2);
     dict_delete(d);
 }
 
@@ -109,6 +93,462 @@ void test_dict_remove() {
     dict_delete(d);
 }
 
+void test_dict_many() {
+    Dict d = dict_create(0);
+    static int values[1000];
+    char key[16];
+
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i;
+        sprintf(key, "key%d", i);
+        dict_setref(d, key, values + i);
+    }
+    assert(dict_size(d) == 1000);
+
+    for (int i = 0; i < 1000; i += 2) {
+        sprintf(key, "key%d", i);
+        dict_remove(d, key);
+    }
+    assert(dict_size(d) == 500);
+
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        int* value = dict_get(d, key);
+        if (i % 2) assert(value && *value == i);
+        else assert(value == NULL);
+    }
+
+    const char** keys = dict_keys(d);
+    for (size_t i = 0; i < dict_size(d); i++)
+        assert(*(int*)dict_get(d, keys[i]) % 2 == 1);
+    dict_delete(d);
+}
+
+void test_dict_resize() {
+    Dict d = dict_create(0);
+    dict_set_load_factor(d, 0.5f, 0.1f);
+    char key[16];
+
+    for (int i = 0; i < 5000; i++) {
+        sprintf(key, "%d", i);
+        dict_setobj(d, key, newobj(int, i));
+        // every element stays reachable while the table is resized
+        for (int j = i; j >= 0 && j > i - 10; j--) {
+            sprintf(key, "%d", j);
+            assert(*(int*)dict_get(d, key) == j);
+        }
+    }
+    assert(dict_size(d) == 5000);
+    assert(dict_capacity(d) >= 10000);
+
+    for (int i = 0; i < 4990; i++) {
+        sprintf(key, "%d", i);
+        dict_remove(d, key);
+    }
+    // lookups finish moving the elements to the smaller table
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%d", 4990 + i % 10);
+        assert(*(int*)dict_get(d, key) == 4990 + i % 10);
+    }
+    assert(dict_size(d) == 10);
+    assert(dict_capacity(d) < 1000);
+    dict_delete(d);
+}
+
+void test_dict_long_keys() {
+    Dict d = dict_create(0);
+    char key[256];
+    memset(key, 'k', sizeof(key));
+
+    // keys sharing a long prefix must not be truncated into one
+    for (int len = 1; len < 200; len++) {
+        key[len] = '\0';
+        dict_setobj(d, key, newobj(int, len));
+        key[len] = 'k';
+    }
+    assert(dict_size(d) == 199);
+
+    for (int len = 1; len < 200; len++) {
+        key[len] = '\0';
+        assert(*(int*)dict_get(d, key) == len);
+        if (len % 3 == 0) dict_remove(d, key);
+        key[len] = 'k';
+    }
+    assert(dict_size(d) == 133);
+
+    const char** keys = dict_keys(d);
+    for (size_t i = 0; i < dict_size(d); i++)
+        assert((size_t)*(int*)dict_get(d, keys[i]) == strlen(keys[i]));
+    dict_delete(d);
+}
+
+void test_dict_get_len() {
+    Dict d = dict_create(0);
+    int a = 1, b = 2;
+    dict_setref(d, "key", &a);
+    dict_setref(d, "keys", &b);
+
+    assert(dict_get_len(d, "keys", 3) == &a);
+    assert(dict_get_len(d, "keystone", 4) == &b);
+    assert(dict_get_len(d, "ke", 2) == NULL);
+    assert(dict_hash("key", 3, 1) == dict_hash("keys", 3, 1));
+    assert(dict_hash("key", 3, 1) != dict_hash("key", 3, 2));
+    dict_delete(d);
+}
+
+typedef struct { short x, y; } Point;
+DICT_TYPEDEF(Point, int);
+
+void test_tdict() {
+    int_floatDict d = TDICT_CREATE(int, float);
+    for (int i = 0; i < 1000; i++)
+        TDICT_SET(d, i, i * 0.5f);
+    TDICT_SET(d, 10, -1.0f);
+    assert(d->size == 1000);
+
+    for (int i = 0; i < 1000; i += 2)
+        assert(TDICT_REMOVE(d, i) == true);
+    assert(TDICT_REMOVE(d, 0) == false);
+    assert(d->size == 500);
+
+    for (int i = 0; i < 1000; i++) {
+        float* value = TDICT_GET(d, i);
+        if (i % 2) assert(value && *value == i * 0.5f);
+        else assert(value == NULL);
+    }
+
+    size_t count = 0;
+    TDICT_FOR_EACH(entry, d) {
+        assert(entry->key % 2 == 1);
+        count++;
+    }
+    assert(count == 500);
+    tdict_delete(d);
+
+    Point_intDict points = TDICT_CREATE(Point, int);
+    TDICT_SET(points, ((Point){1, 2}), 12);
+    TDICT_SET(points, ((Point){2, 1}), 21);
+    assert(*TDICT_GET(points, ((Point){1, 2})) == 12);
+    assert(*TDICT_GET(points, ((Point){2, 1})) == 21);
+    assert(TDICT_GET(points, ((Point){1, 1})) == NULL);
+    tdict_delete(points);
+}
+
+void test_dict_iter() {
+    Dict d = dict_create(0);
+    char key[16];
+    static int seen[3000];
+
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "%d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+
+    size_t count = 0;
+    for (DictIter it = dict_iter_begin(d); dict_iter_next(d, &it);) {
+        assert(strlen(it.key) == it.len);
+        assert(it.destructor == free);
+        count++;
+    }
+    assert(count == 1000);
+
+    // grow and remove while iterating
+    int added = 1000;
+    for (DictIter it = dict_iter_begin(d); dict_iter_next(d, &it);) {
+        int value = *(int*)it.value;
+        seen[value]++;
+        if (value % 2 && value < 1000) {
+            dict_remove(d, it.key);
+        } else if (added < 3000) {
+            sprintf(key, "%d", added);
+            dict_setobj(d, key, newobj(int, added++));
+        }
+    }
+    for (int i = 0; i < 1000; i++)
+        assert(seen[i] >= 1);
+    assert(dict_size(d) == (size_t)added - 500);
+    dict_delete(d);
+}
+
+void test_dict_many_keys() {
+    Dict d = dict_create(0);
+    static char names[600][16];
+    const char* keys[600];
+    void* values[600];
+
+    for (int i = 0; i < 600; i++) {
+        sprintf(names[i], "key%d", i);
+        keys[i] = names[i];
+        values[i] = names[i];
+    }
+    dict_set_many(d, keys, values, 300, NULL);
+    assert(dict_size(d) == 300);
+
+    dict_get_many(d, keys, 600, values);
+    for (int i = 0; i < 600; i++) {
+        assert(values[i] == (i < 300 ? names[i] : NULL));
+        assert(values[i] == dict_get(d, keys[i]));
+    }
+    dict_delete(d);
+}
+
+static size_t int_size(const void* value) {
+    (void)value;
+    return sizeof(int);
+}
+
+void test_dict_mmap() {
+    const char* path = "test_dict_mmap.bin";
+    Dict d = dict_create(0);
+    char key[64];
+    for (int i = 0; i < 3000; i++) {
+        sprintf(key, i % 2 ? "short %d" : "a key long enough for the arena %d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+    dict_setref(d, "null", NULL);
+    assert(dict_save(d, path, int_size));
+    dict_delete(d);
+
+    Dict m = dict_open_mmap(path);
+    assert(m != NULL);
+    assert(dict_size(m) == 3001);
+    for (int i = 0; i < 3000; i++) {
+        sprintf(key, i % 2 ? "short %d" : "a key long enough for the arena %d", i);
+        int* value = dict_get(m, key);
+        assert(value && *value == i);
+    }
+    assert(dict_get(m, "null") == NULL);
+    assert(dict_get(m, "missing") == NULL);
+
+    // read-only
+    dict_setref(m, "missing", key);
+    dict_remove(m, "short 1");
+    assert(dict_size(m) == 3001);
+    assert(dict_get(m, "missing") == NULL);
+
+    size_t count = 0;
+    for (DictIter it = dict_iter_begin(m); dict_iter_next(m, &it);) {
+        assert(strlen(it.key) == it.len);
+        count++;
+    }
+    assert(count == 3001);
+
+    // values saved as strings
+    Dict s = dict_create(0);
+    dict_setref(s, "hello", "world");
+    assert(dict_save(s, path, NULL));
+    dict_delete(s);
+    s = dict_open_mmap(path);
+    assert(strcmp(dict_get(s, "hello"), "world") == 0);
+
+    // the first mapping still sees the old file
+    assert(*(int*)dict_get(m, "short 1") == 1);
+    dict_delete(m);
+    dict_delete(s);
+
+    // entries pointing outside the file are rejected at open
+    FILE* file = fopen(path, "r+b");
+    char image[4096];
+    size_t image_size = fread(image, 1, sizeof(image), file);
+    uint64_t capacity;
+    memcpy(&capacity, image + 32, sizeof(capacity));
+    memset(image + 48 + capacity, 0x7f, capacity * 32);
+    rewind(file);
+    assert(fwrite(image, 1, image_size, file) == image_size);
+    fclose(file);
+    assert(dict_open_mmap(path) == NULL);
+    remove(path);
+
+    assert(dict_open_mmap(path) == NULL);
+}
+
+void test_dict_freeze() {
+    Dict d = dict_create(0);
+    char key[64];
+    for (int i = 0; i < 100000; i++) {
+        sprintf(key, i % 3 ? "key %d" : "a key long enough for the arena %d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+    FrozenDict f = dict_freeze(d);
+    assert(f != NULL);
+    assert(dict_size(d) == 0);
+    dict_delete(d);
+
+    assert(frozen_dict_size(f) == 100000);
+    for (int i = 0; i < 100000; i++) {
+        sprintf(key, i % 3 ? "key %d" : "a key long enough for the arena %d", i);
+        int* value = frozen_dict_get(f, key);
+        assert(value && *value == i);
+    }
+    for (int i = 100000; i < 200000; i++) {
+        sprintf(key, "key %d", i);
+        assert(frozen_dict_get(f, key) == NULL);
+    }
+    assert(*(int*)frozen_dict_get_len(f, "key 1234567", 5) == 1);
+    frozen_dict_delete(f);
+
+    for (int n = 0; n < 50; n++) {
+        d = dict_create(0);
+        for (int i = 0; i < n; i++) {
+            sprintf(key, "%d", i);
+            dict_setobj(d, key, newobj(int, i));
+        }
+        f = dict_freeze(d);
+        dict_delete(d);
+        assert(frozen_dict_size(f) == (size_t)n);
+        for (int i = 0; i < n + 10; i++) {
+            sprintf(key, "%d", i);
+            int* value = frozen_dict_get(f, key);
+            assert(i < n ? value && *value == i : value == NULL);
+        }
+        frozen_dict_delete(f);
+    }
+}
+
+void test_dict_ordered() {
+    Dict d = dict_create_ordered(0);
+    char key[64];
+    for (int i = 0; i < 10000; i++) {
+        sprintf(key, i % 2 ? "%d" : "a key long enough for the arena %d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+    for (int i = 0; i < 10000; i += 3) {
+        sprintf(key, i % 2 ? "%d" : "a key long enough for the arena %d", i);
+        dict_remove(d, key);
+    }
+    // updating keeps the position
+    int* one = dict_get(d, "1");
+    dict_setobj(d, "1", newobj(int, 1));
+    free(one);
+
+    int last = -1;
+    size_t count = 0;
+    for (DictIter it = dict_iter_begin(d); dict_iter_next(d, &it); count++) {
+        int value = *(int*)it.value;
+        assert(value > last && value % 3 != 0);
+        last = value;
+    }
+    assert(count == dict_size(d));
+
+    // removed keys come back at the end, compacting the holes left
+    for (int i = 0; i < 10000; i += 3) {
+        sprintf(key, i % 2 ? "%d" : "a key long enough for the arena %d", i);
+        dict_setobj(d, key, newobj(int, 10000 + i));
+    }
+    assert(dict_size(d) == 10000);
+    const char** keys = dict_keys(d);
+    for (size_t i = 0; i < dict_size(d); i++) {
+        int value = *(int*)dict_get(d, keys[i]);
+        assert(i < 6666 ? value % 3 != 0 : value == 10000 + 3*(int)(i - 6666));
+    }
+
+    // an iteration can go on through removals and compactions
+    count = 0;
+    for (DictIter it = dict_iter_begin(d); dict_iter_next(d, &it); count++) {
+        char removed[64];
+        strcpy(removed, it.key);
+        dict_remove(d, removed);
+        sprintf(key, "new %zu", count);
+        if (count < 5000)
+            dict_setobj(d, key, newobj(int, 0));
+    }
+    assert(dict_size(d) == 0);
+
+    dict_setref(d, "a", "a");
+    dict_clear(d);
+    assert(dict_size(d) == 0);
+    assert(!dict_iter_next(d, &(DictIter){0}));
+    dict_delete(d);
+}
+
+void test_dict_filter() {
+    Dict d = dict_create(0);
+    char key[64];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "key %d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+    assert(dict_enable_filter(d, 100));
+
+    // grows past the size it was built for
+    for (int i = 1000; i < 20000; i++) {
+        sprintf(key, "key %d", i);
+        dict_setobj(d, key, newobj(int, i));
+    }
+    for (int i = 0; i < 20000; i += 2) {
+        sprintf(key, "key %d", i);
+        dict_remove(d, key);
+    }
+    for (int i = 0; i < 20000; i++) {
+        sprintf(key, "key %d", i);
+        int* value = dict_get(d, key);
+        assert(i % 2 ? value && *value == i : value == NULL);
+    }
+    for (int i = 0; i < 100000; i++) {
+        sprintf(key, "missing %d", i);
+        assert(dict_get(d, key) == NULL);
+    }
+
+    DictFilterStats stats = dict_filter_stats(d);
+    assert(stats.lookups == 120000);
+    assert(stats.negatives + stats.false_positives == 110000);
+    assert(stats.false_positive_rate < 0.05);
+    assert(stats.memory > 0);
+
+    const char* keys[] = {"key 1", "key 2", "missing"};
+    void* values[3];
+    dict_get_many(d, keys, 3, values);
+    assert(*(int*)values[0] == 1 && values[1] == NULL && values[2] == NULL);
+
+    dict_clear(d);
+    assert(dict_get(d, "key 1") == NULL);
+    dict_setref(d, "key 1", key);
+    assert(dict_get(d, "key 1") == key);
+    dict_delete(d);
+}
+
+void test_dict_bulk() {
+    const size_t n = 200000;
+    char (*names)[64] = malloc(n * sizeof(*names));
+    const char** keys = malloc(n * sizeof(*keys));
+    void** values = malloc(n * sizeof(*values));
+    for (size_t i = 0; i < n; i++) {
+        // every 10th key repeats the previous one
+        size_t k = i % 10 == 9 ? i - 1 : i;
+        sprintf(names[i], k % 2 ? "%zu" : "a key long enough for the arena %zu", k);
+        keys[i] = names[i];
+        values[i] = names[i];
+    }
+
+    // absurd thread counts are limited
+    size_t threads[] = {1, 4, 0, SIZE_MAX};
+    for (int t = 0; t < 4; t++) {
+        Dict d = dict_build_bulk(keys, values, n, threads[t], NULL);
+        assert(dict_size(d) == n - n/10);
+        for (size_t i = 0; i < n; i++) {
+            size_t last = i % 10 == 8 ? i + 1 : i;
+            assert(dict_get(d, keys[i]) == names[last]);
+        }
+        assert(dict_get(d, "missing") == NULL);
+        dict_setref(d, "missing", NULL);
+        assert(dict_size(d) == n - n/10 + 1);
+        dict_delete(d);
+    }
+
+    Dict d = dict_build_bulk(keys, values, 0, 4, NULL);
+    assert(dict_size(d) == 0);
+    dict_delete(d);
+
+    values[0] = newobj(int, 0);
+    d = dict_build_bulk(keys, values, 1, 4, free);
+    assert(*(int*)dict_get(d, keys[0]) == 0);
+    dict_delete(d);
+
+    free(names);
+    free(keys);
+    free(values);
+}
+
 
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
@@ -121,7 +561,19 @@ int main(int argc, char const *argv[]) {
         test_dict_sets,
         test_dict_get,
         test_dict_set_updating,
-        test_dict_remove
+        test_dict_remove,
+        test_dict_many,
+        test_dict_resize,
+        test_dict_long_keys,
+        test_dict_get_len,
+        test_tdict,
+        test_dict_iter,
+        test_dict_many_keys,
+        test_dict_mmap,
+        test_dict_freeze,
+        test_dict_ordered,
+        test_dict_filter,
+        test_dict_bulk
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);
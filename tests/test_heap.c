@@ -50,6 +50,20 @@ void test_heap_pop() {
     assert(heap->size == 0);
 }
 
+void test_heap_typed() {
+    intHeap heap = heap_create(sizeof(int), 1000, intcmp, MIN_HEAP);
+    for (int i = 0; i < 1000; i++)
+        int_heap_push(heap, (i * 7919) % 1000);
+    assert(int_heap_root(heap) == 0);
+    // typed and generic pushes and pops can be mixed
+    assert(*(int*)heap_pop(heap) == 0);
+    heap_push(heap, (int[]){0});
+    for (int i = 0; i < 1000; i++)
+        assert(int_heap_pop(heap) == i);
+    assert(heap->size == 0);
+    free(heap);
+}
+
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <id>\n", argv[0]);
@@ -58,7 +72,8 @@ int main(int argc, char const *argv[]) {
     void (*tests[])(void) = {
         test_heap_create,
         test_heap_push,
-        test_heap_pop
+        test_heap_pop,
+        test_heap_typed
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);
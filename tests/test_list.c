@@ -148,6 +148,26 @@ void test_list_slice() {
     list_delete(result_false);
 }
 
+void test_list_typed() {
+    intList list = LIST_CREATE(int, 3);
+    int_list_pushback(list, 4);
+    int_list_pushfront(list, 2);
+    int_list_pushfront(list, 1);
+    assert(list->size == 4);
+    assert(*int_list_at(list, 0) == 1 && *int_list_at(list, 3) == 4);
+    assert(*int_list_at(list, -2) == 3);
+
+    // nodes are compatible with the generic functions
+    assert(LIST_POPBACK(list) == 4);
+    list_pushback(list, 1, (int[]){5});
+    assert(int_list_popback(list) == 5);
+    assert(int_list_popfront(list) == 1);
+    assert(int_list_popfront(list) == 2);
+    assert(int_list_popback(list) == 3);
+    assert(list->size == 0 && list->head == NULL && list->tail == NULL);
+    list_delete(list);
+}
+
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <id>\n", argv[0]);
@@ -164,7 +184,8 @@ int main(int argc, char const *argv[]) {
         test_list_at,
         test_list_resize,
         test_list_copy,
-        test_list_slice
+        test_list_slice,
+        test_list_typed
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);
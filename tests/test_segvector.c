@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "segvector.h"
+#include "vector.h"
+#include "utils/bench.h"
+
+void test_segvector_create() {
+    intSegVector v = SEGVECTOR_CREATE(int, 1, 2, 3, 4);
+    assert(v->size == 4);
+    assert(v->internal.dsize == sizeof(int));
+    for (int i = 0; i < 4; i++)
+        assert(SEGVECTOR_AT(v, i) == i + 1);
+    segvector_delete(v);
+
+    // spans several blocks
+    v = segvector_create(sizeof(int), 1000, NULL);
+    assert(v->size == 1000 && SEGVECTOR_AT(v, 0) == 0 && SEGVECTOR_AT(v, 999) == 0);
+    segvector_delete(v);
+}
+
+void test_segvector_stable() {
+    intSegVector v = segvector_create(sizeof(int), 0, NULL);
+    SEGVECTOR_PUSHBACK(v, 0);
+    int* first = segvector_at(v, 0);
+    int* middle = NULL;
+    for (int i = 1; i < 1000000; i++) {
+        SEGVECTOR_PUSHBACK(v, i);
+        if (i == 5000)
+            middle = segvector_at(v, i);
+    }
+    assert(first == segvector_at(v, 0) && *first == 0);
+    assert(middle == segvector_at(v, 5000) && *middle == 5000);
+    for (int i = 0; i < 1000000; i++)
+        assert(SEGVECTOR_AT(v, i) == i);
+
+    // multiple elements crossing block boundaries
+    int values[100];
+    for (int i = 0; i < 100; i++)
+        values[i] = -i;
+    for (int i = 0; i < 100; i++)
+        segvector_pushback(v, 100, values);
+    assert(v->size == 1010000);
+    assert(SEGVECTOR_AT(v, 1000000) == 0 && SEGVECTOR_AT(v, 1009999) == -99);
+    segvector_delete(v);
+}
+
+void test_segvector_popback() {
+    intSegVector v = segvector_create(sizeof(int), 0, NULL);
+    for (int i = 0; i < 10000; i++)
+        SEGVECTOR_PUSHBACK(v, i);
+    for (int i = 9999; i >= 100; i--)
+        assert(SEGVECTOR_POPBACK(v) == i);
+    assert(v->size == 100);
+
+    segvector_shrink(v);
+    assert(v->internal.num_blocks == 3);
+    assert(SEGVECTOR_AT(v, 99) == 99);
+
+    segvector_clear(v);
+    segvector_shrink(v);
+    assert(v->size == 0 && v->internal.num_blocks == 0);
+    segvector_reserve(v, 100000);
+    size_t blocks = v->internal.num_blocks;
+    for (int i = 0; i < 100000; i++)
+        SEGVECTOR_PUSHBACK(v, i);
+    assert(v->internal.num_blocks == blocks);
+    segvector_delete(v);
+}
+
+void test_segvector_latency() {
+    size_t n = 1 << 22;
+    intVector vector = VECTOR_CREATE(int);
+    intSegVector segvector = segvector_create(sizeof(int), 0, NULL);
+    double worst_vector = 0, worst_segvector = 0;
+
+    double total = now();
+    for (size_t i = 0; i < n; i++) {
+        double start = now();
+        vector_pushback(vector, 1, &i);
+        double elapsed = now() - start;
+        if (elapsed > worst_vector)
+            worst_vector = elapsed;
+    }
+    double total_vector = now() - total;
+
+    total = now();
+    for (size_t i = 0; i < n; i++) {
+        double start = now();
+        segvector_pushback(segvector, 1, &i);
+        double elapsed = now() - start;
+        if (elapsed > worst_segvector)
+            worst_segvector = elapsed;
+    }
+    double total_segvector = now() - total;
+
+    printf("vector:    %.3fs total, worst push %.3fms\n", total_vector, worst_vector * 1e3);
+    printf("segvector: %.3fs total, worst push %.3fms\n", total_segvector, worst_segvector * 1e3);
+    assert(segvector->size == n && SEGVECTOR_AT(segvector, n - 1) == (int)(n - 1));
+    vector_delete(vector);
+    segvector_delete(segvector);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_segvector_create,
+        test_segvector_stable,
+        test_segvector_popback,
+        test_segvector_latency
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
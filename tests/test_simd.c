@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "simd.h"
+#include "array.h"
+#include "vector.h"
+#include "utils/bench.h"
+
+static const enum SimdLevel levels[] = {SIMD_SCALAR, SIMD_SSE4, SIMD_AVX2, SIMD_NEON};
+static const char* level_names[] = {"scalar", "sse4.1", "avx2", "neon"};
+
+void test_simd_int() {
+    enum SimdLevel best = simd_level();
+    for (size_t l = 0; l < sizeof(levels)/sizeof(*levels); l++) {
+        if (!simd_set_level(levels[l]))
+            continue;
+        // every size up to a few vectors, to cover the remaining elements
+        for (size_t n = 1; n < 70; n++) {
+            int a[n], b[n];
+            int64_t sum = 0, dot = 0;
+            int min = 1000, max = -1000;
+            for (size_t i = 0; i < n; i++) {
+                a[i] = rand() % 200 - 100;
+                b[i] = a[i] + 1;
+                sum += a[i];
+                dot += (int64_t)a[i] * b[i];
+                min = a[i] < min ? a[i] : min;
+                max = a[i] > max ? a[i] : max;
+            }
+            assert(simd_sum_int(a, n) == sum);
+            assert(simd_dot_int(a, b, n) == dot);
+            assert(simd_min_int(a, n) == min);
+            assert(simd_max_int(a, n) == max);
+            assert(!simd_any_equal_int(a, b, n));
+            b[n - 1] = a[n - 1];
+            assert(simd_any_equal_int(a, b, n));
+
+            assert(simd_find_int(a, n, 500) == n);
+            assert(simd_count_int(a, n, 500) == 0);
+            a[n - 1] = 500;
+            assert(simd_find_int(a, n, 500) == n - 1);
+            a[n / 2] = 500;
+            assert(simd_find_int(a, n, 500) == n / 2);
+            assert(simd_count_int(a, n, 500) == (n > 2 ? 2 : 1));
+        }
+        int big[] = {INT32_MAX, INT32_MAX, INT32_MIN, INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX, 5};
+        assert(simd_sum_int(big, 9) == 7ll * INT32_MAX + INT32_MIN + 5);
+        int wide[] = {INT32_MAX, 0, 0, 0, 0, 0, 0, 0, INT32_MIN};
+        assert(simd_dot_int(wide, wide, 9) == (int64_t)INT32_MAX * INT32_MAX + (int64_t)INT32_MIN * INT32_MIN);
+    }
+    simd_set_level(best);
+}
+
+void test_simd_float() {
+    enum SimdLevel best = simd_level();
+    for (size_t l = 0; l < sizeof(levels)/sizeof(*levels); l++) {
+        if (!simd_set_level(levels[l]))
+            continue;
+        for (size_t n = 1; n < 70; n++) {
+            float a[n], b[n];
+            double sum = 0, dot = 0, magnitude = 0;
+            float min = 1000, max = -1000;
+            for (size_t i = 0; i < n; i++) {
+                a[i] = (rand() % 2000 - 1000) / 8.0f;
+                b[i] = a[i] + 0.5f;
+                sum += a[i];
+                dot += (double)a[i] * b[i];
+                magnitude += fabs((double)a[i] * b[i]) + fabs(a[i]);
+                min = a[i] < min ? a[i] : min;
+                max = a[i] > max ? a[i] : max;
+            }
+            // float rounding, relative to the size of the terms
+            assert(fabs(simd_sum_float(a, n) - sum) <= magnitude * 1e-6);
+            assert(fabs(simd_dot_float(a, b, n) - dot) <= magnitude * 1e-6);
+            assert(simd_min_float(a, n) == min);
+            assert(simd_max_float(a, n) == max);
+            assert(!simd_any_equal_float(a, b, n));
+            b[n - 1] = a[n - 1];
+            assert(simd_any_equal_float(a, b, n));
+
+            assert(simd_find_float(a, n, 0.3f) == n);
+            a[n - 1] = 0.3f;
+            assert(simd_find_float(a, n, 0.3f) == n - 1);
+            assert(simd_count_float(a, n, 0.3f) == 1);
+            a[0] = NAN;
+            assert(simd_find_float(a, n, NAN) == n);
+            assert(simd_count_float(a, n, NAN) == 0);
+        }
+    }
+    simd_set_level(best);
+}
+
+void test_simd_containers() {
+    intVector v = VECTOR_CREATE(int, 4, 8, 15, 16, 23, 42);
+    assert(ARRAY_FIND(v, 15) == 2);
+    assert(ARRAY_FIND(v, 7) == v->size);
+    assert(ARRAY_COUNT(v, 42) == 1);
+    assert(ARRAY_MIN(v) == 4 && ARRAY_MAX(v) == 42);
+    assert(ARRAY_SUM(v) == 108);
+    assert(ARRAY_DOT(v, v) == 16 + 64 + 225 + 256 + 529 + 1764);
+    vector_delete(v);
+
+    floatArray a = ARRAY_CREATE(float, {1.5f, -2.0f, 4.0f});
+    floatArray b = ARRAY_CREATE(float, {0.0f, -2.0f, 1.0f});
+    assert(ARRAY_FIND(a, 4.0f) == 2);
+    assert(ARRAY_MIN(a) == -2.0f && ARRAY_MAX(a) == 4.0f);
+    assert(ARRAY_SUM(a) == 3.5f);
+    assert(ARRAY_DOT(a, b) == 8.0f);
+    assert(ARRAY_ANY_EQUAL(a, b));
+    free(a);
+    free(b);
+}
+
+// Naive loops against the kernels, in elements per nanosecond
+void test_simd_throughput() {
+    size_t n = 1 << 16, rounds = 200;
+    float* a = malloc(n * sizeof(float));
+    float* b = malloc(n * sizeof(float));
+    for (size_t i = 0; i < n; i++) {
+        a[i] = rand() / (float)RAND_MAX;
+        b[i] = -a[i];
+    }
+
+    volatile float sink = 0;
+    double start = now();
+    for (size_t r = 0; r < rounds; r++) {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += a[i] * b[i];
+        sink += sum;
+    }
+    printf("naive dot: %.2f elements/ns\n", n * rounds / (now() - start) / 1e9);
+
+    for (size_t l = 0; l < sizeof(levels)/sizeof(*levels); l++) {
+        if (!simd_set_level(levels[l]))
+            continue;
+        start = now();
+        for (size_t r = 0; r < rounds; r++)
+            sink += simd_dot_float(a, b, n);
+        double dot = n * rounds / (now() - start) / 1e9;
+        start = now();
+        for (size_t r = 0; r < rounds; r++)
+            sink += simd_find_float(a, n, 2.0f);
+        double find = n * rounds / (now() - start) / 1e9;
+        printf("%s dot: %.2f find: %.2f elements/ns\n", level_names[l], dot, find);
+    }
+    free(a);
+    free(b);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_simd_int,
+        test_simd_float,
+        test_simd_containers,
+        test_simd_throughput
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
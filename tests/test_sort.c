@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "sort.h"
+#include "array.h"
+#include "vector.h"
+#include "utils/sort.h"
+#include "utils/bench.h"
+
+typedef struct {
+    int key;
+    char name[12];
+} Record;
+
+static int recordcmp(void* a, void* b) {
+    return intcmp(&((Record*)a)->key, &((Record*)b)->key);
+}
+
+// comparator that is not intcmp, so radix sort is not used
+static int intcmp_cmp(void* a, void* b) {
+    return intcmp(a, b);
+}
+
+static int is_sorted(int* values, size_t n) {
+    for (size_t i = 1; i < n; i++)
+        if (values[i-1] > values[i])
+            return 0;
+    return 1;
+}
+
+// Inputs that defeat naive quicksorts
+static void fill(int* values, size_t n, int pattern) {
+    for (size_t i = 0; i < n; i++) {
+        switch (pattern) {
+        case 0: values[i] = rand(); break;
+        case 1: values[i] = i; break;
+        case 2: values[i] = n - i; break;
+        case 3: values[i] = 7; break;
+        case 4: values[i] = i < n/2 ? i : n - i; break;
+        case 5: values[i] = rand() % 4; break;
+        case 6: values[i] = i % 2 ? (int)i : -(int)i; break;
+        case 7: values[i] = i == n/2 ? -1 : (int)i; break;
+        }
+    }
+}
+
+void test_sort_patterns() {
+    size_t sizes[] = {0, 1, 2, 10, 23, 24, 100, 1000, 100000};
+    for (size_t s = 0; s < sizeof(sizes)/sizeof(*sizes); s++) {
+        size_t n = sizes[s];
+        int* input = malloc(n * sizeof(int) + 1);
+        int* values = malloc(n * sizeof(int) + 1);
+        int* expected = malloc(n * sizeof(int) + 1);
+        for (int pattern = 0; pattern < 8; pattern++) {
+            fill(input, n, pattern);
+            memcpy(expected, input, n * sizeof(int));
+            qsort(expected, n, sizeof(int), (int(*)(const void*, const void*))intcmp);
+
+            memcpy(values, input, n * sizeof(int));
+            gdata_sort(values, n, sizeof(int), intcmp_cmp);
+            assert(memcmp(values, expected, n * sizeof(int)) == 0);
+
+            memcpy(values, input, n * sizeof(int));
+            gdata_sort(values, n, sizeof(int), intcmp);
+            assert(memcmp(values, expected, n * sizeof(int)) == 0);
+        }
+        free(input);
+        free(values);
+        free(expected);
+    }
+}
+
+void test_sort_structs() {
+    size_t n = 50000;
+    Record* records = malloc(n * sizeof(Record));
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = rand() % 1000;
+        snprintf(records[i].name, sizeof(records[i].name), "%d", records[i].key);
+    }
+    gdata_sort(records, n, sizeof(Record), recordcmp);
+    for (size_t i = 0; i < n; i++) {
+        assert(i == 0 || records[i-1].key <= records[i].key);
+        assert(atoi(records[i].name) == records[i].key);
+    }
+    free(records);
+}
+
+void test_sort_radix() {
+    size_t n = 100000;
+    int32_t* ints = malloc(n * sizeof(int32_t));
+    uint64_t* longs = malloc(n * sizeof(uint64_t));
+    float* floats = malloc(n * sizeof(float));
+    double* doubles = malloc(n * sizeof(double));
+    for (size_t i = 0; i < n; i++) {
+        ints[i] = rand() - RAND_MAX/2;
+        longs[i] = (uint64_t)rand() << 33 ^ rand();
+        floats[i] = (rand() - RAND_MAX/2) / 1000.0f;
+        doubles[i] = (rand() - RAND_MAX/2) * 1e-3;
+    }
+    floats[0] = -0.0f;
+    floats[1] = 0.0f;
+    gdata_radix_sort(ints, n, SORT_INT32);
+    gdata_radix_sort(longs, n, SORT_UINT64);
+    gdata_radix_sort(floats, n, SORT_FLOAT);
+    gdata_radix_sort(doubles, n, SORT_DOUBLE);
+    for (size_t i = 1; i < n; i++) {
+        assert(ints[i-1] <= ints[i]);
+        assert(longs[i-1] <= longs[i]);
+        assert(floats[i-1] <= floats[i]);
+        assert(doubles[i-1] <= doubles[i]);
+    }
+
+    int64_t small[] = {5, -3, INT64_MIN, 0, INT64_MAX, -1};
+    gdata_radix_sort(small, 6, SORT_INT64);
+    assert(small[0] == INT64_MIN && small[1] == -3 && small[5] == INT64_MAX);
+    free(ints);
+    free(longs);
+    free(floats);
+    free(doubles);
+}
+
+void test_sort_containers() {
+    intArray array = ARRAY_CREATE(int, {5, 3, 9, 1, 7});
+    array_sort(array, intcmp);
+    intArray expected_array = ARRAY_CREATE(int, {1, 3, 5, 7, 9});
+    assert(array_equals(array, expected_array));
+    free(array);
+    free(expected_array);
+
+    floatVector vector = VECTOR_CREATE(float, 0.5f, 0.25f, -1.0f, 0.75f);
+    VECTOR_PUSHFRONT(vector, 0.1f);
+    vector_sort(vector, floatcmp);
+    float expected[] = {-1.0f, 0.1f, 0.25f, 0.5f, 0.75f};
+    assert(memcmp(vector->at, expected, sizeof(expected)) == 0);
+    vector_delete(vector);
+
+    int values[1000];
+    for (int i = 0; i < 1000; i++)
+        values[i] = 1000 - i;
+    insertion_sort(values, 1000);
+    assert(is_sorted(values, 1000));
+}
+
+void test_sort_parallel() {
+    size_t n = 300000;
+    int* input = malloc(n * sizeof(int));
+    int* values = malloc(n * sizeof(int));
+    int* expected = malloc(n * sizeof(int));
+    for (int pattern = 0; pattern < 8; pattern++) {
+        fill(input, n, pattern);
+        memcpy(expected, input, n * sizeof(int));
+        gdata_sort(expected, n, sizeof(int), intcmp);
+        for (size_t threads = 2; threads <= 8; threads += 3) {
+            memcpy(values, input, n * sizeof(int));
+            gdata_parallel_sort(values, n, sizeof(int), intcmp_cmp, threads);
+            assert(memcmp(values, expected, n * sizeof(int)) == 0);
+        }
+    }
+    free(input);
+    free(values);
+    free(expected);
+
+    Record* records = malloc(n * sizeof(Record));
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = rand() % 1000;
+        snprintf(records[i].name, sizeof(records[i].name), "%d", records[i].key);
+    }
+    gdata_parallel_sort(records, n, sizeof(Record), recordcmp, 0);
+    for (size_t i = 0; i < n; i++) {
+        assert(i == 0 || records[i-1].key <= records[i].key);
+        assert(atoi(records[i].name) == records[i].key);
+    }
+
+    // few frequent keys go to buckets of their own
+    for (size_t i = 0; i < n; i++) {
+        records[i].key = i % 3 ? rand() % 5 : rand();
+        snprintf(records[i].name, sizeof(records[i].name), "%d", records[i].key);
+    }
+    gdata_parallel_sort(records, n, sizeof(Record), recordcmp, 4);
+    for (size_t i = 0; i < n; i++) {
+        assert(i == 0 || records[i-1].key <= records[i].key);
+        assert(atoi(records[i].name) == records[i].key);
+    }
+    free(records);
+}
+
+void test_sort_parallel_scaling() {
+    size_t n = 4000000;
+    float* input = malloc(n * sizeof(float));
+    float* values = malloc(n * sizeof(float));
+    // distinct values, 16 frequent values, one frequent value mixed with distinct ones
+    const char* names[] = {"distinct", "16 values", "half equal"};
+    for (int pattern = 0; pattern < 3; pattern++) {
+        for (size_t i = 0; i < n; i++) {
+            float x = rand() / (float)RAND_MAX;
+            input[i] = pattern == 0 ? x : pattern == 1 ? (int)(x * 16) : i % 2 ? 0.5f : x;
+        }
+        for (size_t threads = 1; threads <= 16; threads *= 2) {
+            memcpy(values, input, n * sizeof(float));
+            double start = now();
+            gdata_parallel_sort(values, n, sizeof(float), floatcmp, threads);
+            printf("%s, threads: %zu, %.3fs\n", names[pattern], threads, now() - start);
+            for (size_t i = 1; i < n; i++)
+                assert(values[i-1] <= values[i]);
+        }
+    }
+    free(input);
+    free(values);
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <id>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void (*tests[])(void) = {
+        test_sort_patterns,
+        test_sort_structs,
+        test_sort_radix,
+        test_sort_containers,
+        test_sort_parallel,
+        test_sort_parallel_scaling
+    };
+    const int n_tests = sizeof(tests)/sizeof(*tests);
+    int index = atoi(argv[1]);
+    if (index > -1 && index < n_tests) {
+        tests[index]();
+    } else {
+        printf("Tests available: %i\n", n_tests);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -31,7 +31,7 @@ void test_stack_clear() {
 }
 
 void test_stack_push() {
-    Stack s = {0, {sizeof(int), NULL}, NULL};
+    Stack s = {.internal.dsize = sizeof(int)};
     int a = 5;
     stack_push(&s, &a);
     assert(*(int*)s.head->data == a);
@@ -108,6 +108,22 @@ void test_stack_equals() {
     stack_delete(b);
 }
 
+STACK_TYPEDEF(int);
+
+void test_stack_typed() {
+    intStack stack = STACK_CREATE(int, 1, 2);
+    int_stack_push(stack, 3);
+    STACK_PUSH(stack, 4);
+    assert(stack->size == 4);
+    assert(int_stack_value(stack) == 4);
+    assert(STACK_AT(stack, 2) == 3);
+    assert(int_stack_pop(stack) == 4);
+    assert(STACK_POP(stack) == 3);
+    assert(int_stack_pop(stack) == 2);
+    assert(stack->size == 1);
+    stack_delete(stack);
+}
+
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <id>\n", argv[0]);
@@ -123,7 +139,8 @@ int main(int argc, char const *argv[]) {
         test_stack_copy,
         test_stack_at,
         test_stack_value,
-        test_stack_equals
+        test_stack_equals,
+        test_stack_typed
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "vector.h"
 
 #define TEST_VALUE 1,2,3,4
@@ -120,6 +122,306 @@ void test_vector_popfront() {
     vector_delete(b);
 }
 
+void test_vector_growth() {
+    intVector v = VECTOR_ALLOCATE(int, 0);
+    size_t reallocs = 0, alloc = v->internal.alloc;
+    for (int i = 0; i < 100000; i++) {
+        VECTOR_PUSHBACK(v, i);
+        reallocs += v->internal.alloc != alloc;
+        alloc = v->internal.alloc;
+    }
+    assert(reallocs < 20);
+    for (int i = 0; i < 100000; i++)
+        assert(v->at[i] == i);
+
+    // alternating push and pop at the growth point does not reallocate
+    while (v->size < v->internal.alloc)
+        VECTOR_PUSHBACK(v, 0);
+    alloc = v->internal.alloc;
+    for (int i = 0; i < 100; i++) {
+        VECTOR_PUSHBACK(v, 1);
+        assert(VECTOR_POPBACK(v) == 1);
+    }
+    assert(v->internal.alloc == alloc * 2);
+
+    // shrinks when mostly empty
+    while (v->size > 10)
+        vector_popback(v);
+    assert(v->internal.alloc < 100);
+
+    for (int i = 0; i < 1000; i++)
+        VECTOR_PUSHFRONT(v, -i);
+    assert(v->size == 1010);
+    assert(v->at[0] == -999 && v->at[999] == 0 && v->at[1000] == 0);
+    for (int i = 0; i < 1000; i++)
+        assert(VECTOR_POPFRONT(v) == -999 + i);
+    assert(v->size == 10);
+    vector_delete(v);
+}
+
+void test_vector_reserve() {
+    intVector v = VECTOR_CREATE(int, TEST_VALUE);
+    vector_reserve(v, 1000);
+    assert(v->internal.alloc >= 1000);
+    int* at = v->at;
+    for (int i = 4; i < 1000; i++)
+        VECTOR_PUSHBACK(v, i);
+    assert(v->at == at);
+    assert(v->at[3] == 4 && v->at[999] == 999);
+
+    while (v->size > 4)
+        vector_popfront(v);
+    vector_shrink_to_fit(v);
+    assert(v->internal.alloc == 4 && v->internal.offset == 0);
+    assert(v->at[0] == 996 && v->at[3] == 999);
+
+    VECTOR_PUSHBACK(v, 1000);
+    assert(v->at[4] == 1000);
+    vector_delete(v);
+
+    // a smaller growth factor reallocates more often, wasting less memory
+    v = VECTOR_ALLOCATE(int, 0);
+    vector_set_growth_factor(v, 1.25f);
+    size_t reallocs = 0, alloc = v->internal.alloc;
+    for (int i = 0; i < 100000; i++) {
+        VECTOR_PUSHBACK(v, i);
+        reallocs += v->internal.alloc != alloc;
+        alloc = v->internal.alloc;
+    }
+    assert(reallocs > 20 && reallocs < 100);
+    assert(v->internal.alloc < 100000 * 1.25 + 1);
+    for (int i = 0; i < 100000; i++)
+        assert(v->at[i] == i);
+    vector_delete(v);
+}
+
+VECTOR_SMALL_TYPEDEF(int, 8);
+
+// malloc() until ctx's budget is spent, then out of memory
+static void* budget_alloc(void* ctx, size_t size) {
+    int* budget = ctx;
+    return (*budget)-- > 0 ? malloc(size) : NULL;
+}
+
+static void budget_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx, (void)size;
+    free(ptr);
+}
+
+void test_vector_small() {
+    intSmallVector8 v = VECTOR_SMALL_CREATE(intSmallVector8, 1, 2, 3);
+    assert(v->size == 3);
+    assert(v->at == v->small);
+    for (int i = 4; i <= 8; i++)
+        VECTOR_PUSHBACK(v, i);
+    assert(v->at == v->small);
+
+    // spills to the heap past the inline capacity
+    VECTOR_PUSHBACK(v, 9, 10);
+    VECTOR_PUSHFRONT(v, 0);
+    assert(v->at != v->small);
+    assert(v->size == 11);
+    for (int i = 0; i < 11; i++)
+        assert(v->at[i] == i);
+
+    intVector copy = vector_copy(v);
+    assert(vector_equals(copy, v));
+    vector_delete(copy);
+
+    // and goes back inline when it fits again
+    vector_popfront(v);
+    vector_popback(v);
+    vector_popback(v);
+    vector_popback(v);
+    vector_shrink_to_fit(v);
+    assert(v->at == v->small);
+    for (int i = 0; i < 7; i++)
+        assert(v->at[i] == i + 1);
+    vector_delete(v);
+
+    v = VECTOR_SMALL_CREATE(intSmallVector8);
+    assert(v->size == 0);
+    vector_reserve(v, 100);
+    assert(v->internal.alloc >= 100 && v->at != v->small);
+    vector_delete(v);
+
+    // failing to spill the initial values returns NULL
+    int budget = 1;
+    struct gdata_allocator allocator = {budget_alloc, NULL, budget_free, &budget};
+    gdata_set_default_allocator(&allocator);
+    v = VECTOR_SMALL_CREATE(intSmallVector8, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+    gdata_set_default_allocator(NULL);
+    assert(v == NULL && budget < 0);
+}
+
+void test_vector_typed() {
+    intVector v = VECTOR_CREATE(int);
+    for (int i = 0; i < 1000; i++)
+        int_vector_pushback(v, i);
+    for (int i = 1; i <= 1000; i++)
+        int_vector_pushfront(v, -i);
+    assert(v->size == 2000);
+    for (int i = 0; i < 2000; i++)
+        assert(*int_vector_at(v, i) == i - 1000);
+
+    intVector copy = vector_copy(v);
+    assert(int_vector_equals(v, copy));
+    *int_vector_at(copy, 5) = 0;
+    assert(!int_vector_equals(v, copy));
+    vector_delete(copy);
+
+    // shrinking goes through the generic functions
+    for (int i = 0; i < 999; i++) {
+        assert(int_vector_popfront(v) == i - 1000);
+        assert(int_vector_popback(v) == 999 - i);
+    }
+    assert(v->size == 2);
+    assert(v->internal.alloc < 2000);
+    assert(int_vector_popback(v) == 0 && int_vector_popfront(v) == -1);
+    vector_delete(v);
+
+    intSmallVector8 small = VECTOR_SMALL_CREATE(intSmallVector8, 1, 2);
+    int_small_vector8_pushback(small, 3);
+    assert(small->at == small->small && *int_small_vector8_at(small, 2) == 3);
+    vector_delete(small);
+}
+
+void test_vector_insert_range() {
+    intVector v = VECTOR_CREATE(int, 0, 1, 2, 7, 8, 9);
+    // closer to the end
+    VECTOR_INSERT(v, 3, 3, 4, 5, 6);
+    // closer to the begin
+    VECTOR_INSERT(v, 1, -1, -2);
+    VECTOR_INSERT(v, 0, -3);
+    VECTOR_INSERT(v, v->size, 10);
+    int expected[] = {-3, 0, -1, -2, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    assert(v->size == 14);
+    for (int i = 0; i < 14; i++)
+        assert(v->at[i] == expected[i]);
+    vector_delete(v);
+
+    v = VECTOR_CREATE(int);
+    for (int i = 0; i < 1000; i++)
+        vector_insert_range(v, v->size / 3, 1, &i);
+    assert(v->size == 1000);
+    vector_delete(v);
+}
+
+void test_vector_erase_range() {
+    intVector v = VECTOR_CREATE(int);
+    for (int i = 0; i < 20; i++)
+        VECTOR_PUSHBACK(v, i);
+    vector_erase_range(v, 2, 5);
+    vector_erase_range(v, 10, 15);
+    vector_erase_range(v, 4, 4);
+    int expected[] = {0, 1, 5, 6, 7, 8, 9, 10, 11, 12, 18, 19};
+    assert(v->size == 12);
+    for (int i = 0; i < 12; i++)
+        assert(v->at[i] == expected[i]);
+
+    // erasing most elements releases the memory
+    for (int i = 0; i < 10000; i++)
+        VECTOR_PUSHBACK(v, i);
+    vector_erase_range(v, 1, v->size - 1);
+    assert(v->size == 2 && v->at[0] == 0 && v->at[1] == 9999);
+    assert(v->internal.alloc < 100);
+    vector_delete(v);
+}
+
+static bool is_odd(void* element, void* ctx) {
+    (void)ctx;
+    return *(int*)element % 2;
+}
+
+static bool greater_than(void* element, void* ctx) {
+    return *(int*)element > *(int*)ctx;
+}
+
+void test_vector_remove_if() {
+    intVector v = VECTOR_CREATE(int);
+    for (int i = 0; i < 10000; i++)
+        VECTOR_PUSHBACK(v, i);
+    assert(vector_remove_if(v, is_odd, NULL) == 5000);
+    assert(v->size == 5000);
+    for (int i = 0; i < 5000; i++)
+        assert(v->at[i] == 2*i);
+
+    int limit = 10;
+    assert(vector_remove_if(v, greater_than, &limit) == 4994);
+    assert(v->size == 6 && v->at[5] == 10);
+    assert(v->internal.alloc < 100);
+    assert(vector_remove_if(v, greater_than, &limit) == 0);
+    vector_delete(v);
+}
+
+void test_vector_map_file() {
+    const char* path = "test_vector_map.bin";
+    remove(path);
+    intVector v = vector_map_file(path, sizeof(int));
+    assert(v && v->size == 0);
+    for (int i = 0; i < 100000; i++)
+        VECTOR_PUSHBACK(v, i);
+    VECTOR_PUSHFRONT(v, -1);
+    vector_delete(v);
+
+    FILE* file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    // header page, then the elements
+    assert(ftell(file) == sysconf(_SC_PAGESIZE) + 100001 * sizeof(int));
+    fclose(file);
+
+    v = vector_map_file(path, sizeof(int));
+    assert(v->size == 100001);
+    assert(v->at[0] == -1 && v->at[1] == 0 && v->at[100000] == 99999);
+    vector_erase_range(v, 10, v->size);
+    assert(VECTOR_POPFRONT(v) == -1);
+    vector_delete(v);
+
+    v = vector_map_file(path, sizeof(int));
+    assert(v->size == 9 && v->at[8] == 8);
+    vector_delete(v);
+    remove(path);
+}
+
+void test_vector_map_file_reopen() {
+    const char* path = "test_vector_reopen.bin";
+    remove(path);
+    // a process ending without vector_delete(), the inline functions included
+    pid_t child = fork();
+    if (child == 0) {
+        intVector v = vector_map_file(path, sizeof(int));
+        for (int i = 0; i < 1000; i++)
+            int_vector_pushback(v, i);
+        for (int i = 1; i <= 10; i++)
+            int_vector_pushfront(v, -i);
+        assert(int_vector_popback(v) == 999);
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    intVector v = vector_map_file(path, sizeof(int));
+    assert(v && v->size == 1009);
+    assert(v->at[0] == -10 && v->at[9] == -1 && v->at[10] == 0 && v->at[1008] == 998);
+    // open by another vector, or with another element size
+    assert(vector_map_file(path, sizeof(int)) == NULL);
+    vector_delete(v);
+    assert(vector_map_file(path, sizeof(double)) == NULL);
+    remove(path);
+
+    // files not made by vector_map_file() are refused and left as they are
+    FILE* file = fopen(path, "wb");
+    fwrite("0123456789abc", 1, 13, file);
+    fclose(file);
+    assert(vector_map_file(path, sizeof(int)) == NULL);
+    file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    assert(ftell(file) == 13);
+    fclose(file);
+    remove(path);
+}
+
 int main(int argc, char const *argv[]) {
     if (argc < 2) {
         printf("Usage: %s <id>\n", argv[0]);
@@ -134,7 +436,16 @@ int main(int argc, char const *argv[]) {
         test_vector_remove,
         test_vector_pushfront,
         test_vector_popback,
-        test_vector_popfront
+        test_vector_popfront,
+        test_vector_growth,
+        test_vector_reserve,
+        test_vector_small,
+        test_vector_typed,
+        test_vector_insert_range,
+        test_vector_erase_range,
+        test_vector_remove_if,
+        test_vector_map_file,
+        test_vector_map_file_reopen
     };
     const int n_tests = sizeof(tests)/sizeof(*tests);
     int index = atoi(argv[1]);